@@ -0,0 +1,152 @@
+#include "Adafruit_BusIO_Async.h"
+
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+
+/*!
+ *    @brief  Create an empty queue
+ */
+Adafruit_BusIO_AsyncQueue::Adafruit_BusIO_AsyncQueue(void) {
+  for (uint8_t i = 0; i < BUSIO_ASYNC_POOL_SIZE; i++) {
+    _pool[i].state = BUSIO_ASYNC_FREE;
+  }
+  _head = _count = 0;
+}
+
+/*!
+ *    @brief  Queue up a read of a whole register
+ *    @param  reg The register to read
+ *    @param  done Optional function to call with the result. If given, the
+ * descriptor is released right after it is called
+ *    @param  arg Passed to done as is
+ *    @return Handle to check on the read with, -1 if the pool is empty
+ */
+busio_async_handle_t Adafruit_BusIO_AsyncQueue::read(
+    Adafruit_BusIO_Register *reg, busio_async_done_t done, void *arg) {
+  return _queue(OP_READ, reg, 0, done, arg);
+}
+
+/*!
+ *    @brief  Queue up a write of a whole register
+ *    @param  reg The register to write
+ *    @param  value The value to write
+ *    @param  done Optional function to call when written. If given, the
+ * descriptor is released right after it is called
+ *    @param  arg Passed to done as is
+ *    @return Handle to check on the write with, -1 if the pool is empty
+ */
+busio_async_handle_t Adafruit_BusIO_AsyncQueue::write(
+    Adafruit_BusIO_Register *reg, uint32_t value, busio_async_done_t done,
+    void *arg) {
+  return _queue(OP_WRITE, reg, value, done, arg);
+}
+
+/*!
+ *    @brief  Queue up a read-modify-write of a slice of bits
+ *    @param  bits The bits to change
+ *    @param  value The value to put in them, not shifted
+ *    @param  done Optional function to call when written. If given, the
+ * descriptor is released right after it is called
+ *    @param  arg Passed to done as is
+ *    @return Handle to check on the write with, -1 if the pool is empty
+ */
+busio_async_handle_t Adafruit_BusIO_AsyncQueue::write(
+    Adafruit_BusIO_RegisterBits *bits, uint32_t value, busio_async_done_t done,
+    void *arg) {
+  return _queue(OP_WRITE_BITS, bits, value, done, arg);
+}
+
+/*!
+ *    @brief  Run the oldest queued access. Call this often from the main loop
+ *    @return True if an access was run, false if the queue was empty
+ */
+bool Adafruit_BusIO_AsyncQueue::poll(void) {
+  if (!_count) {
+    return false;
+  }
+  uint8_t i = _fifo[_head];
+  _head = (_head + 1) % BUSIO_ASYNC_POOL_SIZE;
+  _count--;
+
+  bool ok = false;
+  switch (_pool[i].op) {
+  case OP_READ:
+    ok = ((Adafruit_BusIO_Register *)_pool[i].target)->read(&_pool[i].value);
+    break;
+  case OP_WRITE:
+    ok = ((Adafruit_BusIO_Register *)_pool[i].target)->write(_pool[i].value);
+    break;
+  case OP_WRITE_BITS:
+    ok = ((Adafruit_BusIO_RegisterBits *)_pool[i].target)->write(
+        _pool[i].value);
+    break;
+  }
+
+  _pool[i].state = ok ? BUSIO_ASYNC_DONE : BUSIO_ASYNC_FAILED;
+  if (_pool[i].done) {
+    _pool[i].done(_pool[i].arg, ok, _pool[i].value);
+    _pool[i].state = BUSIO_ASYNC_FREE;
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Check on a queued access
+ *    @param  handle The handle the access was queued with
+ *    @return Where the access is at
+ */
+busio_async_state_t
+Adafruit_BusIO_AsyncQueue::state(busio_async_handle_t handle) {
+  if ((handle < 0) || (handle >= BUSIO_ASYNC_POOL_SIZE)) {
+    return BUSIO_ASYNC_FREE;
+  }
+  return _pool[handle].state;
+}
+
+/*!
+ *    @brief  The value a finished read got, or a write wrote
+ *    @param  handle The handle the access was queued with
+ *    @return The value, 0 if the access failed
+ */
+uint32_t Adafruit_BusIO_AsyncQueue::value(busio_async_handle_t handle) {
+  if ((handle < 0) || (handle >= BUSIO_ASYNC_POOL_SIZE)) {
+    return 0;
+  }
+  return _pool[handle].value;
+}
+
+/*!
+ *    @brief  Hand a finished access's descriptor back to the pool. The handle
+ * must not be used after this. Accesses queued with a done function are
+ * released for you
+ *    @param  handle The handle the access was queued with
+ */
+void Adafruit_BusIO_AsyncQueue::release(busio_async_handle_t handle) {
+  if ((handle < 0) || (handle >= BUSIO_ASYNC_POOL_SIZE) ||
+      (_pool[handle].state == BUSIO_ASYNC_QUEUED)) {
+    return;
+  }
+  _pool[handle].state = BUSIO_ASYNC_FREE;
+}
+
+busio_async_handle_t
+Adafruit_BusIO_AsyncQueue::_queue(op_t op, void *target, uint32_t value,
+                                  busio_async_done_t done, void *arg) {
+  for (uint8_t i = 0; i < BUSIO_ASYNC_POOL_SIZE; i++) {
+    if (_pool[i].state != BUSIO_ASYNC_FREE) {
+      continue;
+    }
+    _pool[i].target = target;
+    _pool[i].value = value;
+    _pool[i].done = done;
+    _pool[i].arg = arg;
+    _pool[i].op = op;
+    _pool[i].state = BUSIO_ASYNC_QUEUED;
+    _fifo[(_head + _count) % BUSIO_ASYNC_POOL_SIZE] = i;
+    _count++;
+    return i;
+  }
+  return -1;
+}
+
+#endif // SPI exists
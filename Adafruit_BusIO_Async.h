@@ -0,0 +1,62 @@
+#ifndef Adafruit_BusIO_Async_h
+#define Adafruit_BusIO_Async_h
+
+#include <Adafruit_BusIO_Register.h>
+#include <Arduino.h>
+
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+
+#ifndef BUSIO_ASYNC_POOL_SIZE
+#define BUSIO_ASYNC_POOL_SIZE 8 ///< How many register accesses can be queued
+#endif
+
+/*!
+ * @brief A queue of register reads and writes, run one at a time from the main
+ * loop by poll(), so many devices can have accesses outstanding without the
+ * sketch blocking on each in turn. Descriptors come from a fixed pool, nothing
+ * is allocated.
+ */
+class Adafruit_BusIO_AsyncQueue {
+public:
+  Adafruit_BusIO_AsyncQueue(void);
+
+  busio_async_handle_t read(Adafruit_BusIO_Register *reg,
+                            busio_async_done_t done = nullptr,
+                            void *arg = nullptr);
+  busio_async_handle_t write(Adafruit_BusIO_Register *reg, uint32_t value,
+                             busio_async_done_t done = nullptr,
+                             void *arg = nullptr);
+  busio_async_handle_t write(Adafruit_BusIO_RegisterBits *bits, uint32_t value,
+                             busio_async_done_t done = nullptr,
+                             void *arg = nullptr);
+
+  bool poll(void);
+  busio_async_state_t state(busio_async_handle_t handle);
+  uint32_t value(busio_async_handle_t handle);
+  void release(busio_async_handle_t handle);
+  /*!   @brief  How many accesses are waiting to run
+   *    @return Number of queued accesses */
+  uint8_t pending(void) { return _count; }
+
+private:
+  typedef enum { OP_READ, OP_WRITE, OP_WRITE_BITS } op_t;
+
+  struct {
+    void *target; // register, or register bits for OP_WRITE_BITS
+    uint32_t value;
+    busio_async_done_t done;
+    void *arg;
+    op_t op;
+    busio_async_state_t state;
+  } _pool[BUSIO_ASYNC_POOL_SIZE];
+
+  uint8_t _fifo[BUSIO_ASYNC_POOL_SIZE]; // pool indices, oldest first
+  uint8_t _head, _count;
+
+  busio_async_handle_t _queue(op_t op, void *target, uint32_t value,
+                              busio_async_done_t done, void *arg);
+};
+
+#endif // SPI exists
+#endif // Adafruit_BusIO_Async_h
@@ -0,0 +1,58 @@
+#ifndef Adafruit_BusIO_CRC_h
+#define Adafruit_BusIO_CRC_h
+
+#include <Arduino.h>
+
+typedef uint32_t (*busio_crc_update_t)(uint32_t crc, const uint8_t *data,
+                                       size_t len);
+
+/*!
+ * @brief The parameters of one CRC flavor, and the table-driven kernel that
+ * folds bytes into it
+ */
+typedef struct {
+  busio_crc_update_t update; ///< Kernel that runs bytes through the CRC
+  uint32_t init;             ///< Starting value of the CRC register
+  uint32_t xorout;           ///< Value XOR'd onto the register at the end
+  uint8_t width;             ///< Size of the CRC in bits: 8, 16 or 32
+  bool lsb_first;            ///< True if the CRC goes out low byte first
+} busio_crc_model_t;
+
+extern const busio_crc_model_t busio_crc8_smbus;     ///< SMBus PEC, poly 0x07
+extern const busio_crc_model_t busio_crc8_sensirion; ///< Sensirion, poly 0x31
+extern const busio_crc_model_t busio_crc8_tmc;       ///< Trinamic UART CRC
+extern const busio_crc_model_t busio_crc16_ccitt;    ///< CRC-16/CCITT-FALSE
+extern const busio_crc_model_t busio_crc16_modbus;   ///< CRC-16/MODBUS
+extern const busio_crc_model_t busio_crc32;          ///< CRC-32 (zlib, PNG)
+
+/*!
+ * @brief Runs a CRC over data, either in one go with compute() or a piece at
+ * a time as the bytes go over the bus. Lookup tables live in flash, and only
+ * the ones for models that are actually used get linked in.
+ */
+class Adafruit_BusIO_CRC {
+public:
+  Adafruit_BusIO_CRC(const busio_crc_model_t *model = &busio_crc8_smbus);
+
+  void reset(void);
+  void update(const uint8_t *data, size_t len);
+  /*!   @brief  Run a single byte through the CRC
+   *    @param  data The byte to add */
+  void update(uint8_t data) { update(&data, 1); }
+  uint32_t value(void);
+  /*!   @brief  How many bytes the CRC takes up on the wire
+   *    @return 1, 2 or 4 */
+  uint8_t size(void) { return _model->width / 8; }
+  void put(uint8_t *out);
+  bool check(const uint8_t *in);
+
+  static uint32_t compute(const busio_crc_model_t *model, const uint8_t *data,
+                          size_t len);
+  static uint8_t smbus(uint8_t crc, const uint8_t *data, size_t len);
+
+private:
+  const busio_crc_model_t *_model;
+  uint32_t _crc;
+};
+
+#endif // Adafruit_BusIO_CRC_h
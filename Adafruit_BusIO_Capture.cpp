@@ -0,0 +1,302 @@
+#include "Adafruit_BusIO_Capture.h"
+
+#define BUSIO_CAPTURE_VERSION 1
+
+static busio_capture_sink_t capture_sink = nullptr;
+static void *capture_arg = nullptr;
+static uint8_t capture_depth = 0; // calls nested inside a captured one
+static uint32_t capture_last = 0;
+static uint8_t *capture_rdata = nullptr;
+static size_t capture_rlen = 0;
+
+/*!
+ *    @brief  Start sending every transaction to a sink. Only does anything
+ *    when the library is built with BUSIO_ENABLE_CAPTURE defined
+ *    @param  sink Function handed the capture, a few bytes at a time
+ *    @param  arg Argument handed to the sink
+ */
+void Adafruit_BusIO_Capture::begin(busio_capture_sink_t sink, void *arg) {
+  static const uint8_t header[] = {'B', 'I', 'O', 'C', BUSIO_CAPTURE_VERSION};
+  capture_sink = nullptr;
+  capture_arg = arg;
+  capture_depth = 0;
+  capture_last = micros();
+  if (sink) {
+    sink(arg, header, sizeof(header));
+  }
+  capture_sink = sink;
+}
+
+/*!
+ *    @brief  Stop capturing
+ */
+void Adafruit_BusIO_Capture::end(void) { capture_sink = nullptr; }
+
+/*!
+ *    @brief  Record the start of a transaction. What is sent is recorded right
+ *    away since the read buffer may be the same memory. Transactions made
+ *    from inside this one (e.g. a register read going through a device) are
+ *    not recorded on their own.
+ *    @param  bus Which kind of device
+ *    @param  op Which call
+ *    @param  device I2C address or SPI CS pin
+ *    @param  prefix Bytes sent first, may be nullptr
+ *    @param  prefix_len Number of prefix bytes
+ *    @param  wdata Bytes sent after the prefix, may be nullptr
+ *    @param  wlen Number of bytes sent after the prefix
+ *    @param  rdata Where the received bytes will be once finish() is called
+ *    @param  rlen Number of bytes received
+ */
+void Adafruit_BusIO_Capture::start(busio_capture_bus_t bus,
+                                   busio_capture_op_t op, uint8_t device,
+                                   const uint8_t *prefix, size_t prefix_len,
+                                   const uint8_t *wdata, size_t wlen,
+                                   uint8_t *rdata, size_t rlen) {
+  if (!capture_sink || capture_depth++) {
+    return;
+  }
+  uint32_t now = micros();
+  uint8_t head[2] = {(uint8_t)(bus | (op << 2)), device};
+  _emit(head, 2);
+  _varint(now - capture_last);
+  _varint(prefix_len + wlen);
+  _varint(rlen);
+  _emit(prefix, prefix_len);
+  _emit(wdata, wlen);
+  capture_last = now;
+  capture_rdata = rdata;
+  capture_rlen = rlen;
+}
+
+/*!
+ *    @brief  Record the end of the transaction start() began: what was
+ *    received and whether it went through. Does nothing if none was started
+ *    @param  ok What the transaction returned
+ *    @return ok, so this can wrap the return value
+ */
+bool Adafruit_BusIO_Capture::finish(bool ok) {
+  if (!capture_depth || --capture_depth) {
+    return ok;
+  }
+  uint8_t status = ok;
+  _emit(capture_rdata, capture_rlen);
+  _emit(&status, 1);
+  return ok;
+}
+
+void Adafruit_BusIO_Capture::_emit(const uint8_t *data, size_t len) {
+  if (capture_sink && data && len) {
+    capture_sink(capture_arg, data, len);
+  }
+}
+
+void Adafruit_BusIO_Capture::_varint(uint32_t value) {
+  uint8_t buf[5];
+  uint8_t n = 0;
+  while (value >= 0x80) {
+    buf[n++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  buf[n++] = value;
+  _emit(buf, n);
+}
+
+/*!
+ *    @brief  Create a replay of a capture
+ *    @param  data The capture, as handed to the sink, header and all
+ *    @param  len Number of bytes in the capture
+ */
+Adafruit_BusIO_Replay::Adafruit_BusIO_Replay(const uint8_t *data, size_t len) {
+  _data = data;
+  _len = len;
+  rewind();
+}
+
+/*!
+ *    @brief  Go back to the first transaction and clear the mismatch count
+ */
+void Adafruit_BusIO_Replay::rewind(void) {
+  _mismatches = 0;
+  _last = micros();
+  if ((_len < 5) || memcmp(_data, "BIOC", 4) ||
+      (_data[4] != BUSIO_CAPTURE_VERSION)) {
+    _pos = _len; // not a capture we can read, act as if it were empty
+  } else {
+    _pos = 5;
+  }
+}
+
+/*!
+ *    @brief  Read the next transaction out of the capture
+ *    @param  record Filled in with the transaction, its buffers point into
+ *    the capture
+ *    @return False once there are no more (complete) transactions
+ */
+bool Adafruit_BusIO_Replay::next(busio_capture_record_t *record) {
+  if ((_len - _pos) < 2) {
+    return false;
+  }
+  size_t pos = _pos;
+  uint8_t kind = _data[_pos++];
+  record->bus = (busio_capture_bus_t)(kind & 0x03);
+  record->op = (busio_capture_op_t)(kind >> 2);
+  record->device = _data[_pos++];
+
+  uint32_t wlen, rlen;
+  if (!_varint(&record->dt_us) || !_varint(&wlen) || !_varint(&rlen) ||
+      ((_len - _pos) < ((size_t)wlen + rlen + 1))) {
+    _pos = pos;
+    return false;
+  }
+  record->wdata = _data + _pos;
+  record->wlen = wlen;
+  _pos += wlen;
+  record->rdata = _data + _pos;
+  record->rlen = rlen;
+  _pos += rlen;
+  record->ok = _data[_pos++];
+  return true;
+}
+
+bool Adafruit_BusIO_Replay::_varint(uint32_t *value) {
+  *value = 0;
+  for (uint8_t shift = 0; (shift < 35) && (_pos < _len); shift += 7) {
+    uint8_t b = _data[_pos++];
+    *value |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ *    @brief  Take the next transaction to stand in for a device, waiting out
+ *    the recorded gap first if setRealtime() asked for it
+ *    @param  record Filled in with the transaction
+ *    @param  write True for a call that only sends, false if it reads
+ *    @return False if the capture has run out or the transaction is of the
+ *    wrong kind (which counts as a mismatch)
+ */
+bool Adafruit_BusIO_Replay::_take(busio_capture_record_t *record, bool write) {
+  if (!next(record)) {
+    _mismatches++;
+    return false;
+  }
+  if (_realtime) {
+    while ((micros() - _last) < record->dt_us) {
+      yield();
+    }
+  }
+  _last = micros();
+
+  bool reads = (record->op != BUSIO_CAPTURE_WRITE) &&
+               (record->op != BUSIO_CAPTURE_WRITE_REGISTER);
+  if (reads == write) {
+    _mismatches++;
+    return false;
+  }
+  return true;
+}
+
+bool Adafruit_BusIO_Replay::_match(const busio_capture_record_t *record,
+                                   const uint8_t *a, size_t alen,
+                                   const uint8_t *b, size_t blen) {
+  bool same = (record->wlen == (alen + blen)) &&
+              (!alen || !memcmp(record->wdata, a, alen)) &&
+              (!blen || !memcmp(record->wdata + alen, b, blen));
+  if (!same) {
+    _mismatches++;
+  }
+  return same;
+}
+
+/*!
+ *    @brief  Adafruit_GenericDevice read function answering with the next
+ *    recorded read
+ *    @param  obj The Adafruit_BusIO_Replay
+ *    @param  buffer Where the recorded bytes go
+ *    @param  len Number of bytes asked for
+ *    @return What the recorded read returned
+ */
+bool Adafruit_BusIO_Replay::read(void *obj, uint8_t *buffer, size_t len) {
+  Adafruit_BusIO_Replay *replay = (Adafruit_BusIO_Replay *)obj;
+  busio_capture_record_t rec;
+  if (!replay->_take(&rec, false)) {
+    return false;
+  }
+  replay->_match(&rec, nullptr, 0, nullptr, 0);
+  if (rec.rlen != len) {
+    replay->_mismatches++;
+  }
+  memcpy(buffer, rec.rdata, (rec.rlen < len) ? rec.rlen : len);
+  return rec.ok;
+}
+
+/*!
+ *    @brief  Adafruit_GenericDevice write function checking the bytes
+ *    against the next recorded write
+ *    @param  obj The Adafruit_BusIO_Replay
+ *    @param  buffer The bytes being sent
+ *    @param  len Number of bytes being sent
+ *    @return What the recorded write returned
+ */
+bool Adafruit_BusIO_Replay::write(void *obj, const uint8_t *buffer,
+                                  size_t len) {
+  Adafruit_BusIO_Replay *replay = (Adafruit_BusIO_Replay *)obj;
+  busio_capture_record_t rec;
+  if (!replay->_take(&rec, true)) {
+    return false;
+  }
+  replay->_match(&rec, buffer, len, nullptr, 0);
+  return rec.ok;
+}
+
+/*!
+ *    @brief  Adafruit_GenericDevice register read function, answering with
+ *    the next recorded read. A register read captured on I2C or SPI (a
+ *    write_then_read) replays just as well as one captured here.
+ *    @param  obj The Adafruit_BusIO_Replay
+ *    @param  addr_buf The register address bytes, checked against the capture
+ *    @param  addrsiz Number of address bytes
+ *    @param  data Where the recorded bytes go
+ *    @param  datalen Number of bytes asked for
+ *    @return What the recorded read returned
+ */
+bool Adafruit_BusIO_Replay::readRegister(void *obj, uint8_t *addr_buf,
+                                         uint8_t addrsiz, uint8_t *data,
+                                         uint16_t datalen) {
+  Adafruit_BusIO_Replay *replay = (Adafruit_BusIO_Replay *)obj;
+  busio_capture_record_t rec;
+  if (!replay->_take(&rec, false)) {
+    return false;
+  }
+  replay->_match(&rec, addr_buf, addrsiz, nullptr, 0);
+  if (rec.rlen != datalen) {
+    replay->_mismatches++;
+  }
+  memcpy(data, rec.rdata, (rec.rlen < datalen) ? rec.rlen : datalen);
+  return rec.ok;
+}
+
+/*!
+ *    @brief  Adafruit_GenericDevice register write function, checking the
+ *    address and data against the next recorded write
+ *    @param  obj The Adafruit_BusIO_Replay
+ *    @param  addr_buf The register address bytes
+ *    @param  addrsiz Number of address bytes
+ *    @param  data The bytes being written
+ *    @param  datalen Number of bytes being written
+ *    @return What the recorded write returned
+ */
+bool Adafruit_BusIO_Replay::writeRegister(void *obj, uint8_t *addr_buf,
+                                          uint8_t addrsiz, const uint8_t *data,
+                                          uint16_t datalen) {
+  Adafruit_BusIO_Replay *replay = (Adafruit_BusIO_Replay *)obj;
+  busio_capture_record_t rec;
+  if (!replay->_take(&rec, true)) {
+    return false;
+  }
+  replay->_match(&rec, addr_buf, addrsiz, data, datalen);
+  return rec.ok;
+}
@@ -0,0 +1,131 @@
+#ifndef Adafruit_BusIO_Capture_h
+#define Adafruit_BusIO_Capture_h
+
+#include <Arduino.h>
+
+/*!
+ * @brief Which kind of device a captured transaction went to
+ */
+typedef enum _busio_capture_bus {
+  BUSIO_CAPTURE_I2C = 0, ///< Adafruit_I2CDevice, device is the address
+  BUSIO_CAPTURE_SPI,     ///< Adafruit_SPIDevice, device is the CS pin
+  BUSIO_CAPTURE_GENERIC, ///< Adafruit_GenericDevice, device is 0
+} busio_capture_bus_t;
+
+/*!
+ * @brief Which call a captured transaction came from
+ */
+typedef enum _busio_capture_op {
+  BUSIO_CAPTURE_WRITE = 0,         ///< write()
+  BUSIO_CAPTURE_READ,              ///< read()
+  BUSIO_CAPTURE_WRITE_THEN_READ,   ///< write_then_read()
+  BUSIO_CAPTURE_TRANSFER,          ///< write_and_read(), full duplex
+  BUSIO_CAPTURE_READ_REGISTER,     ///< readRegister()
+  BUSIO_CAPTURE_WRITE_REGISTER,    ///< writeRegister()
+} busio_capture_op_t;
+
+/*!
+ * @brief One transaction, as read back by Adafruit_BusIO_Replay
+ */
+typedef struct {
+  busio_capture_bus_t bus; ///< Kind of device
+  busio_capture_op_t op;   ///< Which call it was
+  uint8_t device;          ///< I2C address or SPI CS pin
+  bool ok;                 ///< What the call returned
+  uint32_t dt_us;          ///< Time since the transaction before, in us
+  const uint8_t *wdata;    ///< Bytes sent, prefix/register address first
+  size_t wlen;             ///< Number of bytes sent
+  const uint8_t *rdata;    ///< Bytes received
+  size_t rlen;             ///< Number of bytes received
+} busio_capture_record_t;
+
+/*!
+ * @brief Takes the next few bytes of a capture
+ * @param arg The argument given to Adafruit_BusIO_Capture::begin()
+ * @param data The bytes
+ * @param len Number of bytes
+ */
+typedef void (*busio_capture_sink_t)(void *arg, const uint8_t *data,
+                                     size_t len);
+
+/*!
+ * @brief Records every transaction the I2C, SPI and generic devices make,
+ * when the library is built with BUSIO_ENABLE_CAPTURE defined. The stream is
+ * handed to a sink function (to write to an SD card, a serial port...) as
+ *
+ *     "BIOC" version
+ *     then per transaction: kind device dt_us wlen rlen wdata rdata ok
+ *
+ * where kind is bus | (op << 2), ok is one byte, and dt_us, wlen and rlen
+ * are LEB128 varints. Adafruit_SPIDevice::writeStream() and writeRepeated()
+ * are left out, their payload is never in RAM all at once, and so is
+ * transferBatch(), which is several transfers in one.
+ */
+class Adafruit_BusIO_Capture {
+public:
+  static void begin(busio_capture_sink_t sink, void *arg = nullptr);
+  static void end(void);
+
+  static void start(busio_capture_bus_t bus, busio_capture_op_t op,
+                    uint8_t device, const uint8_t *prefix, size_t prefix_len,
+                    const uint8_t *wdata, size_t wlen, uint8_t *rdata,
+                    size_t rlen);
+  static bool finish(bool ok);
+
+private:
+  static void _emit(const uint8_t *data, size_t len);
+  static void _varint(uint32_t value);
+};
+
+#ifdef BUSIO_ENABLE_CAPTURE
+///< Start capturing a transaction, the bytes to send are recorded right away
+#define BUSIO_CAPTURE_START(bus, op, dev, pre, prelen, w, wlen, r, rlen)       \
+  Adafruit_BusIO_Capture::start(bus, op, dev, pre, prelen, w, wlen, r, rlen)
+///< Finish capturing a transaction, evaluates to ok
+#define BUSIO_CAPTURE_END(ok) Adafruit_BusIO_Capture::finish(ok)
+#else
+#define BUSIO_CAPTURE_START(bus, op, dev, pre, prelen, w, wlen, r, rlen)
+#define BUSIO_CAPTURE_END(ok) (ok)
+#endif
+
+/*!
+ * @brief Reads a capture back, one transaction at a time, and can stand in
+ * for the devices through Adafruit_GenericDevice: writes are checked against
+ * what was recorded, reads get the recorded responses
+ */
+class Adafruit_BusIO_Replay {
+public:
+  Adafruit_BusIO_Replay(const uint8_t *data, size_t len);
+
+  bool next(busio_capture_record_t *record);
+  void rewind(void);
+  /*!   @brief  Wait out the recorded time between transactions when standing
+   *    in for a device, rather than going as fast as possible
+   *    @param  realtime True to keep the recorded timing */
+  void setRealtime(bool realtime) { _realtime = realtime; }
+  /*!   @brief  How many calls didn't match the capture while standing in for
+   *    a device (different call, or different bytes sent)
+   *    @return Number of mismatches since the last rewind() */
+  uint32_t mismatches(void) { return _mismatches; }
+
+  static bool read(void *obj, uint8_t *buffer, size_t len);
+  static bool write(void *obj, const uint8_t *buffer, size_t len);
+  static bool readRegister(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                           uint8_t *data, uint16_t datalen);
+  static bool writeRegister(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                            const uint8_t *data, uint16_t datalen);
+
+private:
+  const uint8_t *_data;
+  size_t _len, _pos;
+  bool _realtime = false;
+  uint32_t _mismatches = 0;
+  uint32_t _last = 0;
+
+  bool _varint(uint32_t *value);
+  bool _take(busio_capture_record_t *record, bool write);
+  bool _match(const busio_capture_record_t *record, const uint8_t *a,
+              size_t alen, const uint8_t *b, size_t blen);
+};
+
+#endif // Adafruit_BusIO_Capture_h
@@ -0,0 +1,130 @@
+#include "Adafruit_BusIO_DeviceGroup.h"
+
+static_assert(BUSIO_GROUP_MAX <= 32, "failed() has one bit per device");
+
+/*!
+ *    @brief  Add an SPI device to the group. Devices on the same bus need to
+ *    share clock, mode and bit order, the first one added sets them.
+ *    @param  spidevice The device, begin() already called
+ *    @return False if the group is full
+ */
+bool Adafruit_BusIO_DeviceGroup::add(Adafruit_SPIDevice *spidevice) {
+  if (_count >= BUSIO_GROUP_MAX) {
+    return false;
+  }
+  _spi[_count] = spidevice;
+  _i2c[_count] = nullptr;
+  _count++;
+  return true;
+}
+
+/*!
+ *    @brief  Add an I2C device to the group
+ *    @param  i2cdevice The device, begin() already called
+ *    @return False if the group is full
+ */
+bool Adafruit_BusIO_DeviceGroup::add(Adafruit_I2CDevice *i2cdevice) {
+  if (_count >= BUSIO_GROUP_MAX) {
+    return false;
+  }
+  _spi[_count] = nullptr;
+  _i2c[_count] = i2cdevice;
+  _count++;
+  return true;
+}
+
+/*!
+ *    @brief  Write the same bytes to every device in the group, in as few
+ *    transactions as the buses allow. A device that fails doesn't stop the
+ *    others from being written, see failed().
+ *    @param  buffer Pointer to buffer of data to write
+ *    @param  len Number of bytes from buffer to write
+ *    @param  prefix_buffer Pointer to optional array of data to write before
+ *    buffer, e.g. a register address
+ *    @param  prefix_len Number of bytes from prefix buffer to write
+ *    @return True if every device was written
+ */
+bool Adafruit_BusIO_DeviceGroup::write(const uint8_t *buffer, size_t len,
+                                       const uint8_t *prefix_buffer,
+                                       size_t prefix_len) {
+  uint32_t done = 0;
+  _failed = 0;
+  _transactions = 0;
+
+  for (uint8_t i = 0; i < _count; i++) {
+    if (done & ((uint32_t)1 << i)) {
+      continue;
+    }
+    uint32_t members = (uint32_t)1 << i;
+    _transactions++;
+
+    if (_spi[i]) {
+      // everyone on this bus listens in on one transaction
+      Adafruit_SPIDevice *lead = _spi[i];
+      for (uint8_t j = i + 1; j < _count; j++) {
+        if (_spi[j] && _sameBus(lead, _spi[j])) {
+          members |= (uint32_t)1 << j;
+        }
+      }
+      lead->beginTransaction();
+      for (uint8_t j = i; j < _count; j++) {
+        if (members & ((uint32_t)1 << j)) {
+          _spi[j]->setChipSelect(LOW);
+        }
+      }
+      lead->_send(prefix_buffer, prefix_len);
+      lead->_send(buffer, len);
+      for (uint8_t j = i; j < _count; j++) {
+        if (members & ((uint32_t)1 << j)) {
+          _spi[j]->setChipSelect(HIGH);
+        }
+      }
+      lead->endTransaction();
+
+    } else if (_general_call) {
+      Adafruit_I2CDevice *lead = _i2c[i];
+      for (uint8_t j = i + 1; j < _count; j++) {
+        if (_i2c[j] && _sameBus(lead, _i2c[j])) {
+          members |= (uint32_t)1 << j;
+        }
+      }
+      uint8_t addr = lead->_addr;
+      lead->_addr = 0x00; // the General Call address
+      bool ok = lead->write(buffer, len, true, prefix_buffer, prefix_len);
+      lead->_addr = addr;
+      if (!ok) {
+        _failed |= members;
+      }
+
+    } else if (!_i2c[i]->write(buffer, len, true, prefix_buffer,
+                               prefix_len)) {
+      _failed |= members;
+    }
+    done |= members;
+  }
+  return !_failed;
+}
+
+bool Adafruit_BusIO_DeviceGroup::_sameBus(Adafruit_SPIDevice *a,
+                                          Adafruit_SPIDevice *b) {
+  if (a->_spi != b->_spi) {
+    return false;
+  }
+#ifdef BUSIO_HAS_LINUX
+  if (a->_linux || b->_linux) {
+    return false; // a spidev node is one CS line, the kernel won't share it
+  }
+#endif
+  // software SPI devices share a bus if they share the clock and data pins
+  return a->_spi || ((a->_sck == b->_sck) && (a->_mosi == b->_mosi));
+}
+
+bool Adafruit_BusIO_DeviceGroup::_sameBus(Adafruit_I2CDevice *a,
+                                          Adafruit_I2CDevice *b) {
+#ifdef BUSIO_HAS_LINUX
+  if (a->_linux != b->_linux) {
+    return false;
+  }
+#endif
+  return (a->_wire == b->_wire) && (a->_softwire == b->_softwire);
+}
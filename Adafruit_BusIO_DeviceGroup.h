@@ -0,0 +1,66 @@
+#ifndef Adafruit_BusIO_DeviceGroup_h
+#define Adafruit_BusIO_DeviceGroup_h
+
+#include <Adafruit_I2CDevice.h>
+#include <Adafruit_SPIDevice.h>
+#include <Arduino.h>
+
+///< How many devices a group can hold, at most 32
+#ifndef BUSIO_GROUP_MAX
+#define BUSIO_GROUP_MAX 16
+#endif
+
+/*!
+ * @brief A set of identical devices that get configured the same way. Writes
+ * go to all of them at once where the bus allows: SPI devices sharing a bus
+ * get all their CS lines asserted together, and I2C devices that answer the
+ * General Call can share one transaction per bus. Anything else gets a write
+ * of its own. Reads go to each device as usual.
+ */
+class Adafruit_BusIO_DeviceGroup {
+public:
+  bool add(Adafruit_SPIDevice *spidevice);
+  bool add(Adafruit_I2CDevice *i2cdevice);
+
+  bool write(const uint8_t *buffer, size_t len,
+             const uint8_t *prefix_buffer = nullptr, size_t prefix_len = 0);
+
+  /*!   @brief  Send I2C writes to the General Call address (0x00), once per
+   *    bus, rather than to each device. Only for devices that listen to it.
+   *    @param  enable True to use the General Call */
+  void setGeneralCall(bool enable) { _general_call = enable; }
+  /*!   @brief  Which devices the last write() failed on
+   *    @return Bit n set if the device added n-th failed */
+  uint32_t failed(void) { return _failed; }
+  /*!   @brief  How many bus transactions the last write() took
+   *    @return Number of transactions */
+  uint8_t transactions(void) { return _transactions; }
+  /*!   @brief  How many devices are in the group
+   *    @return Number of devices */
+  uint8_t count(void) { return _count; }
+  /*!   @brief  One of the SPI devices, e.g. to read it back
+   *    @param  index Order it was added in
+   *    @return The device, nullptr if that one is not an SPI device */
+  Adafruit_SPIDevice *spiDevice(uint8_t index) {
+    return (index < _count) ? _spi[index] : nullptr;
+  }
+  /*!   @brief  One of the I2C devices, e.g. to read it back
+   *    @param  index Order it was added in
+   *    @return The device, nullptr if that one is not an I2C device */
+  Adafruit_I2CDevice *i2cDevice(uint8_t index) {
+    return (index < _count) ? _i2c[index] : nullptr;
+  }
+
+private:
+  Adafruit_SPIDevice *_spi[BUSIO_GROUP_MAX];
+  Adafruit_I2CDevice *_i2c[BUSIO_GROUP_MAX];
+  uint8_t _count = 0;
+  bool _general_call = false;
+  uint32_t _failed = 0;
+  uint8_t _transactions = 0;
+
+  static bool _sameBus(Adafruit_SPIDevice *a, Adafruit_SPIDevice *b);
+  static bool _sameBus(Adafruit_I2CDevice *a, Adafruit_I2CDevice *b);
+};
+
+#endif // Adafruit_BusIO_DeviceGroup_h
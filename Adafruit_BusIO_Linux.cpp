@@ -0,0 +1,396 @@
+#include "Adafruit_BusIO_Linux.h"
+#include "Adafruit_BusIO_CRC.h"
+
+#ifdef BUSIO_HAS_LINUX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+static int busio_linux_open(const char *path, int flags) {
+  return ::open(path, flags);
+}
+static int busio_linux_close(int fd) { return ::close(fd); }
+static int busio_linux_ioctl(int fd, unsigned long request, void *arg) {
+  return ::ioctl(fd, request, arg);
+}
+
+const busio_linux_ops_t busio_linux_syscalls = {
+    busio_linux_open, busio_linux_close, busio_linux_ioctl};
+
+// what I2C_RDWR failures mean, the adapter drivers don't all agree
+static Adafruit_BusIO_I2CError busio_linux_i2c_error(int err) {
+  switch (err) {
+  case ENXIO:
+  case EREMOTEIO:
+    return BUSIO_I2C_ERR_ADDR_NACK;
+  case ETIMEDOUT:
+    return BUSIO_I2C_ERR_TIMEOUT;
+  case EMSGSIZE:
+  case EINVAL:
+    return BUSIO_I2C_ERR_TOO_LONG;
+  default:
+    return BUSIO_I2C_ERR_ARB_LOST;
+  }
+}
+
+/*!
+ *    @brief  Create an I2C bus on an i2c-dev node
+ *    @param  path The device node, e.g. "/dev/i2c-1"
+ *    @param  ops The system calls to use, a mock for testing
+ */
+Adafruit_LinuxI2C::Adafruit_LinuxI2C(const char *path,
+                                     const busio_linux_ops_t *ops) {
+  _path = path;
+  _ops = ops;
+}
+
+/*!
+ *    @brief  Open the device node, if it isn't already
+ *    @return False if it can't be opened
+ */
+bool Adafruit_LinuxI2C::begin(void) {
+  if (_fd >= 0) {
+    return true;
+  }
+  _syscalls++;
+  _fd = _ops->open(_path, O_RDWR);
+  _timeout_set = 0;
+  return _fd >= 0;
+}
+
+/*!
+ *    @brief  Close the device node
+ */
+void Adafruit_LinuxI2C::end(void) {
+  if (_fd >= 0) {
+    _syscalls++;
+    _ops->close(_fd);
+    _fd = -1;
+  }
+  _holding = false;
+}
+
+/*!
+ *    @brief  Set the adapter's transfer timeout. The kernel counts in
+ * jiffies of 10ms, so this is rounded up to that
+ *    @param  timeout_us The timeout in microseconds, 0 for the i2c-core
+ *    default of 1s
+ */
+void Adafruit_LinuxI2C::setClockStretchTimeout(uint32_t timeout_us) {
+  _timeout_us = timeout_us;
+}
+
+/*!
+ *    @brief  Turn SMBus PEC on or off. It is worked out here rather than by
+ * the kernel, which only does PEC for SMBus calls, not I2C_RDWR
+ *    @param  enable True to send and check PEC bytes
+ */
+void Adafruit_LinuxI2C::setPEC(bool enable) { _pec = enable; }
+
+/*!
+ *    @brief  See if an address ACKs, with a write of no bytes
+ *    @param  addr The 7-bit address to probe
+ *    @return True if a device ACK'd the address
+ */
+bool Adafruit_LinuxI2C::probe(uint8_t addr) {
+  bool pec = _pec;
+  _pec = false;
+  _holding = false;
+  bool found = _transfer(addr, nullptr, 0, false);
+  _pec = pec;
+  return found;
+}
+
+/*!
+ *    @brief  Write a buffer or two to a device
+ *    @param  addr The 7-bit address of the device
+ *    @param  buffer Pointer to buffer of data to write
+ *    @param  len Number of bytes from buffer to write
+ *    @param  stop Whether to end with a STOP. Without one the bytes are held
+ * and sent with the next read or write, after a repeated start
+ *    @param  prefix_buffer Pointer to optional array of data to write before
+ * buffer
+ *    @param  prefix_len Number of bytes from prefix buffer to write
+ *    @return True if the device ACK'd every byte (always true when held, the
+ * answer comes with the next transfer)
+ */
+bool Adafruit_LinuxI2C::write(uint8_t addr, const uint8_t *buffer, size_t len,
+                              bool stop, const uint8_t *prefix_buffer,
+                              size_t prefix_len) {
+  size_t total = prefix_len + len;
+  if (!stop) {
+    if (_holding || (total > sizeof(_held))) {
+      _holding = false;
+      _error = BUSIO_I2C_ERR_TOO_LONG;
+      return false;
+    }
+    if (prefix_len) {
+      memcpy(_held, prefix_buffer, prefix_len);
+    }
+    if (len) {
+      memcpy(_held + prefix_len, buffer, len);
+    }
+    _held_addr = addr;
+    _held_len = total;
+    _holding = true;
+    _error = BUSIO_I2C_OK;
+    return true;
+  }
+
+  // one message, so a prefix (or the PEC byte) needs the bytes side by side
+  uint8_t *data = (uint8_t *)buffer;
+  if (prefix_len || _pec) {
+    if (total > BUSIO_LINUX_I2C_BUF) {
+      _holding = false;
+      _error = BUSIO_I2C_ERR_TOO_LONG;
+      return false;
+    }
+    if (prefix_len) {
+      memcpy(_buf, prefix_buffer, prefix_len);
+    }
+    if (len) {
+      memcpy(_buf + prefix_len, buffer, len);
+    }
+    data = _buf;
+  }
+  return _transfer(addr, data, total, false);
+}
+
+/*!
+ *    @brief  Read from a device, after a held write if there is one
+ *    @param  addr The 7-bit address of the device
+ *    @param  buffer Pointer to buffer of data to read into
+ *    @param  len Number of bytes to read
+ *    @param  stop Ignored, i2c-dev always ends with a STOP
+ *    @return True if all the bytes were read
+ */
+bool Adafruit_LinuxI2C::read(uint8_t addr, uint8_t *buffer, size_t len,
+                             bool stop) {
+  (void)stop;
+  if (!_pec) {
+    return _transfer(addr, buffer, len, true);
+  }
+  if (len > BUSIO_LINUX_I2C_BUF) {
+    _holding = false;
+    _error = BUSIO_I2C_ERR_TOO_LONG;
+    return false;
+  }
+  if (!_transfer(addr, _buf, len, true)) {
+    return false;
+  }
+  memcpy(buffer, _buf, len);
+  return true;
+}
+
+// One I2C_RDWR: the held write if there is one, then this message. With PEC
+// on, data has room for one more byte, which is the PEC
+bool Adafruit_LinuxI2C::_transfer(uint8_t addr, uint8_t *data, size_t len,
+                                  bool read) {
+  struct i2c_msg msgs[2];
+  struct i2c_rdwr_ioctl_data rdwr = {msgs, 0};
+  uint8_t crc = 0;
+
+  if (_holding) {
+    msgs[0].addr = _held_addr;
+    msgs[0].flags = 0;
+    msgs[0].len = _held_len;
+    msgs[0].buf = _held;
+    rdwr.nmsgs = 1;
+    _holding = false;
+    if (_pec) {
+      uint8_t addr_byte = _held_addr << 1;
+      crc = Adafruit_BusIO_CRC::smbus(crc, &addr_byte, 1);
+      crc = Adafruit_BusIO_CRC::smbus(crc, _held, _held_len);
+    }
+  }
+
+  size_t wire_len = len;
+  if (_pec) {
+    uint8_t addr_byte = (addr << 1) | (read ? 1 : 0);
+    crc = Adafruit_BusIO_CRC::smbus(crc, &addr_byte, 1);
+    if (!read) {
+      crc = Adafruit_BusIO_CRC::smbus(crc, data, len);
+      data[len] = crc;
+    }
+    wire_len++;
+  }
+  if ((_fd < 0) || (wire_len > 0xFFFF)) {
+    _error = (_fd < 0) ? BUSIO_I2C_ERR_ARB_LOST : BUSIO_I2C_ERR_TOO_LONG;
+    return false;
+  }
+
+  msgs[rdwr.nmsgs].addr = addr;
+  msgs[rdwr.nmsgs].flags = read ? I2C_M_RD : 0;
+  msgs[rdwr.nmsgs].len = wire_len;
+  msgs[rdwr.nmsgs].buf = data;
+  rdwr.nmsgs++;
+
+  _applyTimeout();
+  _syscalls++;
+  if (_ops->ioctl(_fd, I2C_RDWR, &rdwr) < 0) {
+    _error = busio_linux_i2c_error(errno);
+    return false;
+  }
+  if (_pec && read &&
+      (data[len] != Adafruit_BusIO_CRC::smbus(crc, data, len))) {
+    _error = BUSIO_I2C_ERR_PEC;
+    return false;
+  }
+  _error = BUSIO_I2C_OK;
+  return true;
+}
+
+// only costs an ioctl when the timeout changed
+void Adafruit_LinuxI2C::_applyTimeout(void) {
+  if (_timeout_us == _timeout_set) {
+    return;
+  }
+  unsigned long jiffies = _timeout_us ? (_timeout_us + 9999) / 10000 : 100;
+  _syscalls++;
+  _ops->ioctl(_fd, I2C_TIMEOUT, (void *)jiffies);
+  _timeout_set = _timeout_us;
+}
+
+/*!
+ *    @brief  Create an SPI bus on a spidev node
+ *    @param  path The device node, e.g. "/dev/spidev0.0"
+ *    @param  ops The system calls to use, a mock for testing
+ */
+Adafruit_LinuxSPI::Adafruit_LinuxSPI(const char *path,
+                                     const busio_linux_ops_t *ops) {
+  _path = path;
+  _ops = ops;
+}
+
+/*!
+ *    @brief  Open the device node, if it isn't already
+ *    @return False if it can't be opened
+ */
+bool Adafruit_LinuxSPI::begin(void) {
+  if (_fd >= 0) {
+    return true;
+  }
+  _syscalls++;
+  _fd = _ops->open(_path, O_RDWR);
+  _mode = 0xFF;
+  _held = false;
+  return _fd >= 0;
+}
+
+/*!
+ *    @brief  Close the device node, dropping anything still queued
+ */
+void Adafruit_LinuxSPI::end(void) {
+  if (_fd >= 0) {
+    _syscalls++;
+    _ops->close(_fd);
+    _fd = -1;
+  }
+  _count = 0;
+  _bytes = 0;
+  _copied = 0;
+}
+
+/*!
+ *    @brief  Start a transaction. The mode only costs an ioctl when it
+ * changes, the clock goes along with every segment
+ *    @param  freq The SPI clock frequency, in Hz
+ *    @param  mode The SPI mode, 0 to 3
+ *    @param  lsbfirst True to shift the low bit first, if the controller can
+ */
+void Adafruit_LinuxSPI::beginTransaction(uint32_t freq, uint8_t mode,
+                                         bool lsbfirst) {
+  _ok = (_fd >= 0);
+  _speed = freq;
+  uint8_t bits = (mode & 0x03) | (lsbfirst ? SPI_LSB_FIRST : 0);
+  if (_ok && (bits != _mode)) {
+    _syscalls++;
+    _ok = (_ops->ioctl(_fd, SPI_IOC_WR_MODE, &bits) >= 0);
+    _mode = _ok ? bits : 0xFF;
+  }
+}
+
+/*!
+ *    @brief  Add a segment to the transaction. Nothing is sent until flush()
+ * or endTransaction(), and the buffers have to stay put until then, apart
+ * from writes of up to BUSIO_LINUX_SPI_COPY bytes, which are copied. Sends
+ * what is queued first if there is no room
+ *    @param  tx Bytes to send, or nullptr to send zeros
+ *    @param  rx Where to put the received bytes, or nullptr to drop them. May
+ * be the same as tx
+ *    @param  len Number of bytes
+ *    @param  cs_change True to let go of CS for a moment after this segment
+ *    @return False if sending what was queued failed
+ */
+bool Adafruit_LinuxSPI::queue(const uint8_t *tx, uint8_t *rx, size_t len,
+                              bool cs_change) {
+  while (len) {
+    size_t n = (len < BUSIO_LINUX_SPI_BUFSIZ) ? len : BUSIO_LINUX_SPI_BUFSIZ;
+    if ((_count == BUSIO_LINUX_SPI_SEGMENTS) ||
+        ((_bytes + n) > BUSIO_LINUX_SPI_BUFSIZ)) {
+      flush(true);
+    }
+    struct spi_ioc_transfer *x = &_xfers[_count++];
+    memset(x, 0, sizeof(*x));
+    x->tx_buf = (uintptr_t)tx;
+    if (tx && !rx && (n <= (sizeof(_copies) - _copied))) {
+      // e.g. a register address, whose buffer the read goes into next
+      memcpy(_copies + _copied, tx, n);
+      x->tx_buf = (uintptr_t)(_copies + _copied);
+      _copied += n;
+    }
+    x->rx_buf = (uintptr_t)rx;
+    x->len = n;
+    x->speed_hz = _speed;
+    x->bits_per_word = 8;
+    x->cs_change = (n == len) && cs_change;
+    _bytes += n;
+    len -= n;
+    tx = tx ? tx + n : nullptr;
+    rx = rx ? rx + n : nullptr;
+  }
+  return _ok;
+}
+
+/*!
+ *    @brief  Send what is queued as one SPI_IOC_MESSAGE
+ *    @param  hold_cs True to keep CS asserted afterwards, because the
+ * transaction goes on
+ *    @return False if any part of the transaction failed
+ */
+bool Adafruit_LinuxSPI::flush(bool hold_cs) {
+  if (!_count) {
+    if (!_held || hold_cs) {
+      return _ok;
+    }
+    // CS was left asserted, an empty segment lets go of it
+    memset(&_xfers[0], 0, sizeof(_xfers[0]));
+    _count = 1;
+  }
+  // on the last segment cs_change means the opposite: stay selected. When
+  // the queue filled up mid-transaction, a segment that asked to let go of
+  // CS does so by ending the message instead
+  struct spi_ioc_transfer *last = &_xfers[_count - 1];
+  last->cs_change = hold_cs && !last->cs_change;
+  if (_fd < 0) {
+    _ok = false;
+  } else {
+    _syscalls++;
+    unsigned long request =
+        _IOC(_IOC_WRITE, SPI_IOC_MAGIC, 0, SPI_MSGSIZE(_count));
+    if (_ops->ioctl(_fd, request, _xfers) < 0) {
+      _ok = false;
+    }
+  }
+  _held = last->cs_change;
+  _count = 0;
+  _bytes = 0;
+  _copied = 0;
+  return _ok;
+}
+
+#endif // BUSIO_HAS_LINUX
@@ -0,0 +1,139 @@
+#ifndef Adafruit_BusIO_Linux_h
+#define Adafruit_BusIO_Linux_h
+
+#include <Adafruit_I2CDevice.h>
+#include <Adafruit_SPIDevice.h>
+#include <Arduino.h>
+
+#ifdef BUSIO_HAS_LINUX
+
+#include <linux/spi/spidev.h>
+
+///< Largest I2C transfer a device makes, writes may get copied this far
+#ifndef BUSIO_LINUX_I2C_BUF
+#define BUSIO_LINUX_I2C_BUF 256
+#endif
+
+#ifndef BUSIO_LINUX_SPI_SEGMENTS
+#define BUSIO_LINUX_SPI_SEGMENTS 16 ///< Segments in one SPI_IOC_MESSAGE
+#endif
+
+///< Most bytes spidev takes in one message, its bufsiz module parameter
+#ifndef BUSIO_LINUX_SPI_BUFSIZ
+#define BUSIO_LINUX_SPI_BUFSIZ 4096
+#endif
+
+///< Bytes of short SPI writes copied when queued, so the caller can reuse them
+#ifndef BUSIO_LINUX_SPI_COPY
+#define BUSIO_LINUX_SPI_COPY 32
+#endif
+
+/*!
+ * @brief The system calls the Linux buses make, so they can be pointed at a
+ * mock to run without real devices (and count what would have been done)
+ */
+typedef struct {
+  int (*open)(const char *path, int flags); ///< Like open(2)
+  int (*close)(int fd);                     ///< Like close(2)
+  /*! Like ioctl(2), returns -1 and sets errno on failure */
+  int (*ioctl)(int fd, unsigned long request, void *arg);
+} busio_linux_ops_t;
+
+extern const busio_linux_ops_t busio_linux_syscalls; ///< The real ones
+
+/*!
+ * @brief An I2C bus on a Linux board, through /dev/i2c-N, usable as the bus
+ * for Adafruit_I2CDevice. Every transfer is one I2C_RDWR ioctl. The kernel
+ * ends each ioctl with a STOP, so a write without a STOP is held back and
+ * goes out in the same ioctl as the transfer after it, with a repeated start
+ * in between: write_then_read() is a single system call.
+ */
+class Adafruit_LinuxI2C {
+public:
+  Adafruit_LinuxI2C(const char *path,
+                    const busio_linux_ops_t *ops = &busio_linux_syscalls);
+
+  bool begin(void);
+  void end(void);
+  void setClockStretchTimeout(uint32_t timeout_us);
+  void setPEC(bool enable);
+
+  bool probe(uint8_t addr);
+  bool write(uint8_t addr, const uint8_t *buffer, size_t len, bool stop = true,
+             const uint8_t *prefix_buffer = nullptr, size_t prefix_len = 0);
+  bool read(uint8_t addr, uint8_t *buffer, size_t len, bool stop = true);
+
+  /*!   @brief  Why the last transaction failed
+   *    @return The error from the last probe/read/write */
+  Adafruit_BusIO_I2CError lastError(void) { return _error; }
+  /*!   @brief  How many system calls the bus has made
+   *    @return Calls to open, close and ioctl since it was created */
+  uint32_t syscalls(void) { return _syscalls; }
+
+private:
+  const char *_path;
+  const busio_linux_ops_t *_ops;
+  int _fd = -1;
+  uint32_t _timeout_us = 0, _timeout_set = 0;
+  bool _pec = false;
+  Adafruit_BusIO_I2CError _error = BUSIO_I2C_OK;
+  uint32_t _syscalls = 0;
+
+  bool _holding = false; // a write is waiting for its repeated start
+  uint8_t _held_addr;
+  size_t _held_len;
+  uint8_t _held[BUSIO_LINUX_I2C_BUF];
+  uint8_t _buf[BUSIO_LINUX_I2C_BUF + 1]; // room for the PEC byte
+
+  bool _transfer(uint8_t addr, uint8_t *data, size_t len, bool read);
+  void _applyTimeout(void);
+};
+
+/*!
+ * @brief An SPI device node on a Linux board, /dev/spidevB.C, usable as the
+ * bus for Adafruit_SPIDevice. The kernel drives CS. Everything sent between
+ * beginTransaction() and endTransaction() is queued up as segments and goes
+ * out as one SPI_IOC_MESSAGE, so a register read or a prefixed write is a
+ * single system call.
+ */
+class Adafruit_LinuxSPI {
+public:
+  Adafruit_LinuxSPI(const char *path,
+                    const busio_linux_ops_t *ops = &busio_linux_syscalls);
+
+  bool begin(void);
+  void end(void);
+  void beginTransaction(uint32_t freq, uint8_t mode, bool lsbfirst);
+  bool queue(const uint8_t *tx, uint8_t *rx, size_t len,
+             bool cs_change = false);
+  bool flush(bool hold_cs);
+  /*!   @brief  Send whatever is queued and let go of CS
+   *    @return False if any part of the transaction failed */
+  bool endTransaction(void) { return flush(false); }
+
+  /*!   @brief  Whether the transaction so far went through
+   *    @return False if an ioctl failed since beginTransaction() */
+  bool ok(void) { return _ok; }
+  /*!   @brief  How many system calls the bus has made
+   *    @return Calls to open, close and ioctl since it was created */
+  uint32_t syscalls(void) { return _syscalls; }
+
+private:
+  const char *_path;
+  const busio_linux_ops_t *_ops;
+  int _fd = -1;
+  uint32_t _speed = 0;
+  uint8_t _mode = 0xFF; // what the device node is set to, 0xFF if unknown
+  bool _held = false;   // CS was left asserted after the last message
+  bool _ok = true;
+  uint32_t _syscalls = 0;
+
+  struct spi_ioc_transfer _xfers[BUSIO_LINUX_SPI_SEGMENTS];
+  uint8_t _count = 0;
+  size_t _bytes = 0;
+  uint8_t _copies[BUSIO_LINUX_SPI_COPY];
+  size_t _copied = 0;
+};
+
+#endif // BUSIO_HAS_LINUX
+#endif // Adafruit_BusIO_Linux_h
@@ -0,0 +1,322 @@
+#include "Adafruit_BusIO_PinSim.h"
+
+#ifdef BUSIO_SIM_PINS
+
+#define PINSIM_UNKNOWN 0xFF // level of a pin not seen yet
+
+static busio_pinsim_event_t pinsim_events[BUSIO_PINSIM_EVENTS];
+static size_t pinsim_count = 0;
+static bool pinsim_overflow = false;
+static uint32_t pinsim_now = 0;
+static uint16_t pinsim_write_ns = 1000, pinsim_read_ns = 1000;
+static busio_pinsim_input_t pinsim_input = nullptr;
+static void *pinsim_input_arg = nullptr;
+static uint8_t pinsim_level[BUSIO_PINSIM_PINS]; // level + 1, 0 if unknown
+static const char *pinsim_names[BUSIO_PINSIM_PINS];
+
+/*!
+ *    @brief  Throw away the recording, set the clock back to 0 and all pins
+ *    back to unknown. Pin names, costs and the input function are kept.
+ */
+void Adafruit_BusIO_PinSim::reset(void) {
+  pinsim_count = 0;
+  pinsim_overflow = false;
+  pinsim_now = 0;
+  memset(pinsim_level, 0, sizeof(pinsim_level));
+}
+
+/*!
+ *    @brief  Set how long a pin write and a pin read take, to model the
+ *    target (digitalWrite() on an AVR is a few us, a port write on a fast
+ *    ARM a few ns). Both default to 1us.
+ *    @param  write_ns Time taken by a pin write, in nanoseconds
+ *    @param  read_ns Time taken by a pin read, in nanoseconds
+ */
+void Adafruit_BusIO_PinSim::setCost(uint16_t write_ns, uint16_t read_ns) {
+  pinsim_write_ns = write_ns;
+  pinsim_read_ns = read_ns;
+}
+
+/*!
+ *    @brief  Set the function that decides what input pins read, e.g. a
+ *    simulated device driving MISO. Without one a pin reads back its own
+ *    level, LOW if it was never written.
+ *    @param  input The function, or nullptr
+ *    @param  arg Argument handed to the function
+ */
+void Adafruit_BusIO_PinSim::setInput(busio_pinsim_input_t input, void *arg) {
+  pinsim_input = input;
+  pinsim_input_arg = arg;
+}
+
+/*!
+ *    @brief  Give a pin a name and put it in the VCD output
+ *    @param  pin The pin
+ *    @param  name Its name in the waveform viewer, must stay valid. nullptr
+ *    takes it out of the VCD output again.
+ */
+void Adafruit_BusIO_PinSim::trace(uint8_t pin, const char *name) {
+  if (pin < BUSIO_PINSIM_PINS) {
+    pinsim_names[pin] = name;
+  }
+}
+
+/*!
+ *    @brief  Drive a pin, recording the transition if the level changes
+ *    @param  pin The pin
+ *    @param  level LOW, or anything else for HIGH
+ */
+void Adafruit_BusIO_PinSim::write(uint8_t pin, uint8_t level) {
+  pinsim_now += pinsim_write_ns;
+  if (pin >= BUSIO_PINSIM_PINS) {
+    return;
+  }
+  level = level ? HIGH : LOW;
+  if (pinsim_level[pin] != level + 1) {
+    pinsim_level[pin] = level + 1;
+    _record(pin, level);
+  }
+}
+
+/*!
+ *    @brief  Read a pin, recording the read
+ *    @param  pin The pin
+ *    @return LOW or HIGH
+ */
+uint8_t Adafruit_BusIO_PinSim::read(uint8_t pin) {
+  pinsim_now += pinsim_read_ns;
+  if (pin >= BUSIO_PINSIM_PINS) {
+    return LOW;
+  }
+  uint8_t level;
+  if (pinsim_input) {
+    level = pinsim_input(pinsim_input_arg, pin, pinsim_now) ? HIGH : LOW;
+  } else {
+    level = (pinsim_level[pin] == HIGH + 1) ? HIGH : LOW;
+  }
+  _record(pin, level | BUSIO_PINSIM_READ);
+  return level;
+}
+
+/*!
+ *    @brief  Let simulated time pass, stands in for delayMicroseconds()
+ *    @param  us How long, in microseconds
+ */
+void Adafruit_BusIO_PinSim::delay(uint32_t us) { pinsim_now += us * 1000; }
+
+/*!
+ *    @brief  The simulated time
+ *    @return Nanoseconds since reset()
+ */
+uint32_t Adafruit_BusIO_PinSim::now(void) { return pinsim_now; }
+
+/*!
+ *    @brief  How many transitions and reads were recorded
+ *    @return Number of events since reset()
+ */
+size_t Adafruit_BusIO_PinSim::events(void) { return pinsim_count; }
+
+/*!
+ *    @brief  Look at one recorded event
+ *    @param  index Which event, 0 is the oldest
+ *    @return The event, nullptr if there's no such event
+ */
+const busio_pinsim_event_t *Adafruit_BusIO_PinSim::event(size_t index) {
+  return (index < pinsim_count) ? &pinsim_events[index] : nullptr;
+}
+
+/*!
+ *    @brief  Whether events were dropped because the recording was full
+ *    @return True if BUSIO_PINSIM_EVENTS was too small
+ */
+bool Adafruit_BusIO_PinSim::overflowed(void) { return pinsim_overflow; }
+
+void Adafruit_BusIO_PinSim::_record(uint8_t pin, uint8_t level) {
+  if (pinsim_count >= BUSIO_PINSIM_EVENTS) {
+    pinsim_overflow = true;
+    return;
+  }
+  busio_pinsim_event_t *e = &pinsim_events[pinsim_count++];
+  e->time_ns = pinsim_now;
+  e->pin = pin;
+  e->level = level;
+}
+
+/*!
+ *    @brief  Write the traced pins out as a Value Change Dump, for GTKWave,
+ *    PulseView and friends. Reads show up as the input pin changing level.
+ *    @param  out Where to write it, e.g. a File
+ */
+void Adafruit_BusIO_PinSim::writeVCD(Print *out) {
+  char ids[BUSIO_PINSIM_PINS];
+  uint8_t shown[BUSIO_PINSIM_PINS];
+  char next_id = '!';
+
+  out->println("$timescale 1ns $end");
+  out->println("$scope module busio $end");
+  for (uint8_t pin = 0; pin < BUSIO_PINSIM_PINS; pin++) {
+    ids[pin] = 0;
+    shown[pin] = PINSIM_UNKNOWN;
+    if (!pinsim_names[pin]) {
+      continue;
+    }
+    ids[pin] = next_id++;
+    out->print("$var wire 1 ");
+    out->print(ids[pin]);
+    out->print(' ');
+    out->print(pinsim_names[pin]);
+    out->println(" $end");
+  }
+  out->println("$upscope $end");
+  out->println("$enddefinitions $end");
+  out->println("#0");
+  out->println("$dumpvars");
+  for (uint8_t pin = 0; pin < BUSIO_PINSIM_PINS; pin++) {
+    if (ids[pin]) {
+      out->print('x');
+      out->print(ids[pin]);
+      out->println();
+    }
+  }
+  out->println("$end");
+
+  uint32_t last = 0;
+  for (size_t i = 0; i < pinsim_count; i++) {
+    const busio_pinsim_event_t *e = &pinsim_events[i];
+    uint8_t level = e->level & ~BUSIO_PINSIM_READ;
+    if (!ids[e->pin] || (shown[e->pin] == level)) {
+      continue;
+    }
+    if (e->time_ns != last) {
+      out->print('#');
+      out->print((unsigned long)e->time_ns);
+      out->println();
+      last = e->time_ns;
+    }
+    shown[e->pin] = level;
+    out->print(level ? '1' : '0');
+    out->print(ids[e->pin]);
+    out->println();
+  }
+}
+
+/*!
+ *    @brief  Go through the recording as an SPI bus and check it against a
+ *    mode. Counted as violations: SCK not at its idle level (CPOL) when CS
+ *    goes low or high, a frame that is not whole bytes, MISO read while the
+ *    device can't be driving the bit being read yet (or anymore), and MOSI
+ *    setup or hold times shorter than asked for.
+ *    @param  sck The clock pin
+ *    @param  mosi The data out pin
+ *    @param  miso The data in pin
+ *    @param  cs The chip select pin
+ *    @param  mode SPI_MODE0 to SPI_MODE3
+ *    @param  report Filled in with what was found
+ *    @param  setup_ns Shortest MOSI setup time the device needs
+ *    @param  hold_ns Shortest MOSI hold time the device needs
+ *    @return False if there was nothing to analyze or events were dropped
+ */
+bool Adafruit_BusIO_PinSim::analyzeSPI(uint8_t sck, uint8_t mosi,
+                                       uint8_t miso, uint8_t cs, uint8_t mode,
+                                       busio_pinsim_spi_report_t *report,
+                                       uint16_t setup_ns, uint16_t hold_ns) {
+  uint8_t cpol = (mode >> 1) & 1, cpha = mode & 1;
+  uint8_t sample_level = !(cpol ^ (mode & 1)); // rising edge for modes 0 and 3
+
+  memset(report, 0, sizeof(*report));
+  report->min_setup_ns = report->min_hold_ns = UINT32_MAX;
+
+  uint8_t sck_level = PINSIM_UNKNOWN;
+  bool in_frame = false, edge_seen = false;
+  bool have_mosi = false, hold_pending = false;
+  uint32_t frame_start = 0, frame_bits = 0, mosi_t = 0, last_edge = 0;
+  uint32_t last_sample = 0, periods = 0, shifts = 0, reads = 0;
+  uint64_t cs_ns = 0, high_ns = 0, low_ns = 0, period_ns = 0;
+
+  for (size_t i = 0; i < pinsim_count; i++) {
+    const busio_pinsim_event_t *e = &pinsim_events[i];
+    uint32_t t = e->time_ns;
+    uint8_t level = e->level & ~BUSIO_PINSIM_READ;
+
+    if (e->level & BUSIO_PINSIM_READ) {
+      // the device drives bit n from shift edge n on (from CS going low
+      // with CPHA 0), so the n-th read has to land in between
+      if ((e->pin == miso) && in_frame && ((shifts - cpha) != reads++)) {
+        report->violations++;
+      }
+    } else if (e->pin == cs) {
+      if (!level && !in_frame) {
+        in_frame = true;
+        edge_seen = hold_pending = false;
+        frame_start = t;
+        frame_bits = shifts = reads = 0;
+        report->frames++;
+        if (sck_level != cpol) {
+          report->violations++;
+        }
+      } else if (level && in_frame) {
+        in_frame = false;
+        cs_ns += t - frame_start;
+        if ((sck_level != cpol) || (frame_bits % 8)) {
+          report->violations++;
+        }
+      }
+    } else if (e->pin == sck) {
+      if (in_frame && edge_seen) {
+        *(sck_level ? &high_ns : &low_ns) += t - last_edge;
+      }
+      sck_level = level;
+      if (!in_frame) {
+        continue;
+      }
+      edge_seen = true;
+      last_edge = t;
+      if (level != sample_level) {
+        shifts++;
+        continue;
+      }
+      if (have_mosi) {
+        uint32_t setup = t - mosi_t;
+        if (setup < report->min_setup_ns) {
+          report->min_setup_ns = setup;
+        }
+        if (setup < setup_ns) {
+          report->violations++;
+        }
+      }
+      if (frame_bits++) {
+        period_ns += t - last_sample;
+        periods++;
+      }
+      report->bits++;
+      last_sample = t;
+      hold_pending = true;
+    } else if (e->pin == mosi) {
+      if (hold_pending) {
+        uint32_t hold = t - last_sample;
+        if (hold < report->min_hold_ns) {
+          report->min_hold_ns = hold;
+        }
+        if (hold < hold_ns) {
+          report->violations++;
+        }
+        hold_pending = false;
+      }
+      mosi_t = t;
+      have_mosi = true;
+    }
+  }
+
+  if (cs_ns) {
+    report->bitrate_hz = (uint64_t)report->bits * 1000000000ULL / cs_ns;
+  }
+  if (period_ns) {
+    report->sck_hz = (uint64_t)periods * 1000000000ULL / period_ns;
+  }
+  if (high_ns + low_ns) {
+    report->duty_pct = high_ns * 100 / (high_ns + low_ns);
+  }
+  return report->frames && !pinsim_overflow;
+}
+
+#endif // BUSIO_SIM_PINS
@@ -0,0 +1,88 @@
+#ifndef Adafruit_BusIO_PinSim_h
+#define Adafruit_BusIO_PinSim_h
+
+#include <Arduino.h>
+
+// Build the library with BUSIO_SIM_PINS defined (on the host) to have
+// software SPI drive these simulated pins instead of the real ones
+#ifdef BUSIO_SIM_PINS
+
+///< How many pin transitions and reads are kept, later ones are dropped
+#ifndef BUSIO_PINSIM_EVENTS
+#define BUSIO_PINSIM_EVENTS 8192
+#endif
+
+///< Pins 0 to BUSIO_PINSIM_PINS-1 can be simulated
+#ifndef BUSIO_PINSIM_PINS
+#define BUSIO_PINSIM_PINS 64
+#endif
+
+///< Set in busio_pinsim_event_t::level when the event is a read of the pin
+#define BUSIO_PINSIM_READ 0x80
+
+/*!
+ * @brief A pin changing level, or being read
+ */
+typedef struct {
+  uint32_t time_ns; ///< Simulated time since reset(), in nanoseconds
+  uint8_t pin;      ///< Which pin
+  uint8_t level;    ///< New level, or the level read | BUSIO_PINSIM_READ
+} busio_pinsim_event_t;
+
+/*!
+ * @brief Says what level an input pin is at, e.g. a simulated MISO
+ * @param arg The argument given to setInput()
+ * @param pin The pin being read
+ * @param time_ns Simulated time of the read
+ * @return LOW or HIGH
+ */
+typedef uint8_t (*busio_pinsim_input_t)(void *arg, uint8_t pin,
+                                        uint32_t time_ns);
+
+/*!
+ * @brief What analyzeSPI() found out about the recorded transfers
+ */
+typedef struct {
+  uint32_t frames;       ///< How many times CS was asserted
+  uint32_t bits;         ///< How many bits were clocked
+  uint32_t bitrate_hz;   ///< Bits per second over the time CS was asserted
+  uint32_t sck_hz;       ///< Average clock rate within a frame
+  uint8_t duty_pct;      ///< Share of the clock period SCK is high
+  uint32_t min_setup_ns; ///< Shortest time MOSI was stable before sampling
+  uint32_t min_hold_ns;  ///< Shortest time MOSI stayed stable after sampling
+  uint32_t violations;   ///< Mode or timing violations, see analyzeSPI()
+} busio_pinsim_spi_report_t;
+
+/*!
+ * @brief Simulated pins for checking software SPI timing on the host: every
+ * transition gets a timestamp from a simple cost model (each pin write and
+ * read takes a fixed time, delays take what they say), and the recording can
+ * be written out as a VCD file or checked against an SPI mode
+ */
+class Adafruit_BusIO_PinSim {
+public:
+  static void reset(void);
+  static void setCost(uint16_t write_ns, uint16_t read_ns);
+  static void setInput(busio_pinsim_input_t input, void *arg = nullptr);
+  static void trace(uint8_t pin, const char *name);
+
+  static void write(uint8_t pin, uint8_t level);
+  static uint8_t read(uint8_t pin);
+  static void delay(uint32_t us);
+
+  static uint32_t now(void);
+  static size_t events(void);
+  static const busio_pinsim_event_t *event(size_t index);
+  static bool overflowed(void);
+
+  static void writeVCD(Print *out);
+  static bool analyzeSPI(uint8_t sck, uint8_t mosi, uint8_t miso, uint8_t cs,
+                         uint8_t mode, busio_pinsim_spi_report_t *report,
+                         uint16_t setup_ns = 0, uint16_t hold_ns = 0);
+
+private:
+  static void _record(uint8_t pin, uint8_t level);
+};
+
+#endif // BUSIO_SIM_PINS
+#endif // Adafruit_BusIO_PinSim_h
@@ -0,0 +1,361 @@
+#include "Adafruit_BusIO_RateScheduler.h"
+
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+
+static_assert(BUSIO_RATE_JOBS <= 32, "service() keeps one bit per job");
+
+/*!
+ *    @brief  Create a scheduler with no jobs
+ *    @param  tick_us How long a tick is, in microseconds. Periods are rounded
+ * to whole ticks, so pick the slowest tick the fastest job allows
+ */
+Adafruit_BusIO_RateScheduler::Adafruit_BusIO_RateScheduler(uint32_t tick_us) {
+  _tick_us = tick_us ? tick_us : 1;
+}
+
+/*!
+ *    @brief  Add a periodic read. Call begin() once all are added
+ *    @param  reg The register (or first register of a block) to read
+ *    @param  buffer Where to put the bytes, len long
+ *    @param  len How many bytes to read
+ *    @param  period_us How often to read, in microseconds
+ *    @param  deadline_us How late after it is due a read may finish before
+ * it counts as a miss, 0 for the whole period
+ *    @param  done Optional function called after every read
+ *    @param  arg Argument handed to done
+ *    @return The job number, for misses() and worstCost(), or -1 if full
+ */
+int8_t Adafruit_BusIO_RateScheduler::add(Adafruit_BusIO_Register *reg,
+                                         uint8_t *buffer, uint8_t len,
+                                         uint32_t period_us,
+                                         uint32_t deadline_us,
+                                         busio_rate_done_t done, void *arg) {
+  if (_count >= BUSIO_RATE_JOBS) {
+    return -1;
+  }
+  uint32_t period = (period_us + _tick_us / 2) / _tick_us;
+  _jobs[_count].reg = reg;
+  _jobs[_count].buffer = buffer;
+  _jobs[_count].len = len;
+  _jobs[_count].period = period ? period : 1;
+  _jobs[_count].deadline_us = deadline_us ? deadline_us : period_us;
+  _jobs[_count].done = done;
+  _jobs[_count].arg = arg;
+  _order[_count] = _count;
+  return _count++;
+}
+
+/*!
+ *    @brief  Work out the schedule and start the clock. Jobs get their
+ * priority from their deadline, and a first tick that keeps them from piling
+ * up on the same ticks as jobs they can't share a transfer with
+ *    @param  timer True if a timer interrupt calls tick(), false to go by the
+ * clock alone
+ *    @return False if there are no jobs
+ */
+bool Adafruit_BusIO_RateScheduler::begin(bool timer) {
+  if (!_count) {
+    return false;
+  }
+
+  // static priorities, insertion sort is plenty for a handful of jobs
+  for (uint8_t k = 1; k < _count; k++) {
+    uint8_t i = _order[k];
+    uint8_t m = k;
+    while (m && ((_jobs[_order[m - 1]].deadline_us > _jobs[i].deadline_us) ||
+                 ((_jobs[_order[m - 1]].deadline_us == _jobs[i].deadline_us) &&
+                  (_jobs[_order[m - 1]].period > _jobs[i].period)))) {
+      _order[m] = _order[m - 1];
+      m--;
+    }
+    _order[m] = i;
+  }
+
+  // Two jobs land on the same tick now and then if their first ticks match
+  // modulo the gcd of their periods. Keep that from happening, unless they
+  // can share a transfer, then make it happen as often as it can
+  for (uint8_t k = 0; k < _count; k++) {
+    uint8_t i = _order[k];
+    uint32_t best = 0;
+    int16_t best_score = 0x7FFF;
+    for (uint32_t p = 0; p < _jobs[i].period; p++) {
+      int16_t score = 0;
+      for (uint8_t m = 0; m < k; m++) {
+        uint8_t j = _order[m];
+        uint32_t g = _gcd(_jobs[i].period, _jobs[j].period);
+        if ((p % g) == (_jobs[j].countdown % g)) {
+          score += _shares(i, j) ? -1 : 1;
+        }
+      }
+      if (score < best_score) {
+        best_score = score;
+        best = p;
+      }
+    }
+    _jobs[i].countdown = best;
+  }
+
+  for (uint8_t i = 0; i < _count; i++) {
+    _jobs[i].pending = false;
+    _jobs[i].misses = 0;
+    _jobs[i].worst_us = 0;
+  }
+  _busy_us = 0;
+  _coalesced = 0;
+  _transfers = 0;
+  _timer = timer;
+  _ticks = 0;
+  _start = _next = _now();
+  return true;
+}
+
+/*!
+ *    @brief  Move the schedule on by one tick. Call this from a timer
+ * interrupt that fires every tick_us if begin() was told there is one, it
+ * only counts, the reads happen in service()
+ */
+void Adafruit_BusIO_RateScheduler::tick(void) {
+  if (_ticks < 255) {
+    _ticks++;
+  }
+}
+
+/*!
+ *    @brief  Do the reads that are due, highest priority first. Reads of the
+ * same registers that are due together go out as one transfer. A job that
+ * comes due again before its last read was done only gets read once, and the
+ * skipped read counts as a miss. Call this often from the main loop
+ *    @return True if anything was read
+ */
+bool Adafruit_BusIO_RateScheduler::service(void) {
+  if (_timer) {
+    noInterrupts();
+    uint8_t ticks = _ticks;
+    _ticks = 0;
+    interrupts();
+    while (ticks--) {
+      _release();
+    }
+  } else {
+    uint32_t now = _now();
+    while ((int32_t)(now - _next) >= 0) {
+      _release();
+    }
+  }
+
+  bool ran = false;
+  for (uint8_t k = 0; k < _count; k++) {
+    uint8_t i = _order[k];
+    if (!_jobs[i].pending) {
+      continue;
+    }
+
+    // gather what can ride along, lo..hi is the span of registers to read
+    uint32_t members = (uint32_t)1 << i;
+    uint8_t n = 1, leader = i;
+    uint16_t lo = _jobs[i].reg->_address;
+    uint16_t hi = lo + _jobs[i].len;
+    bool single = true; // every member starts at lo
+    bool grew = true;
+    while (grew) {
+      grew = false;
+      for (uint8_t m = k + 1; m < _count; m++) {
+        uint8_t j = _order[m];
+        if (!_jobs[j].pending || (members & ((uint32_t)1 << j)) ||
+            !_sameDevice(i, j)) {
+          continue;
+        }
+        uint16_t addr = _jobs[j].reg->_address;
+        uint16_t end = addr + _jobs[j].len;
+        if (single && (addr == lo)) {
+          if (_jobs[j].len > _jobs[leader].len) {
+            leader = j;
+            hi = end;
+          }
+        } else if (_adjacent && !_jobs[i].reg->_crc_model && (addr <= hi) &&
+                   (lo <= end) &&
+                   (((end > hi) ? end : hi) - ((addr < lo) ? addr : lo) <=
+                    BUSIO_RATE_SCRATCH)) {
+          if ((addr < lo) || ((addr == lo) &&
+                              (_jobs[j].len > _jobs[leader].len))) {
+            leader = j;
+          }
+          lo = (addr < lo) ? addr : lo;
+          hi = (end > hi) ? end : hi;
+          single = false;
+        } else {
+          continue;
+        }
+        members |= (uint32_t)1 << j;
+        n++;
+        grew = _adjacent;
+      }
+    }
+
+    // the leader starts at lo, if it also reaches hi it can take the bytes
+    uint8_t scratch[BUSIO_RATE_SCRATCH];
+    bool direct = (_jobs[leader].len == (uint8_t)(hi - lo));
+    uint8_t *data = direct ? _jobs[leader].buffer : scratch;
+    uint32_t t0 = _now();
+    bool ok = _jobs[leader].reg->read(data, hi - lo);
+    uint32_t t = _now();
+    uint32_t cost = (t - t0) / n;
+    _busy_us += t - t0;
+    _transfers++;
+    _coalesced += n - 1;
+    ran = true;
+
+    for (uint8_t j = 0; j < _count; j++) {
+      if (!(members & ((uint32_t)1 << j))) {
+        continue;
+      }
+      if (ok && (!direct || (j != leader))) {
+        memcpy(_jobs[j].buffer, data + (_jobs[j].reg->_address - lo),
+               _jobs[j].len);
+      }
+      _jobs[j].pending = false;
+      if (cost > _jobs[j].worst_us) {
+        _jobs[j].worst_us = cost;
+      }
+      if ((t - _jobs[j].release_us) > _jobs[j].deadline_us) {
+        _jobs[j].misses++;
+      }
+      if (_jobs[j].done) {
+        _jobs[j].done(_jobs[j].arg, ok, _jobs[j].release_us);
+      }
+    }
+  }
+  return ran;
+}
+
+/*!
+ *    @brief  Run the scheduler off a clock other than micros(), e.g. a
+ * virtual one so a schedule can be tried out on a host without hardware
+ *    @param  clock Function returning the time in microseconds, or nullptr
+ * for micros()
+ */
+void Adafruit_BusIO_RateScheduler::setClock(busio_rate_clock_t clock) {
+  _clock = clock;
+}
+
+/*!
+ *    @brief  How many reads finished after their deadline, or were skipped
+ * because the job came due again first
+ *    @param  job The job number from add(), or -1 for all jobs together
+ *    @return Misses since begin()
+ */
+uint32_t Adafruit_BusIO_RateScheduler::misses(int8_t job) {
+  if (job >= 0) {
+    return (job < _count) ? _jobs[job].misses : 0;
+  }
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    total += _jobs[i].misses;
+  }
+  return total;
+}
+
+/*!
+ *    @brief  The longest a job's read has taken. A shared transfer is split
+ * evenly between the jobs on it
+ *    @param  job The job number from add()
+ *    @return Worst read time since begin(), in microseconds
+ */
+uint32_t Adafruit_BusIO_RateScheduler::worstCost(int8_t job) {
+  return ((job >= 0) && (job < _count)) ? _jobs[job].worst_us : 0;
+}
+
+/*!
+ *    @brief  How busy the scheduler has kept the bus
+ *    @return Time spent reading since begin(), in tenths of a percent
+ */
+uint16_t Adafruit_BusIO_RateScheduler::utilization(void) {
+  uint32_t elapsed = _now() - _start;
+  if (!elapsed) {
+    return 0;
+  }
+  return (uint64_t)_busy_us * 1000 / elapsed;
+}
+
+/*!
+ *    @brief  Check the schedule against the worst read times seen so far,
+ * with the hyperbolic bound for fixed priorities: every job makes its
+ * deadline if the product of (1 + worst / deadline) over all jobs is at most
+ * 2. False doesn't mean jobs will miss, only that it isn't guaranteed
+ *    @return True if no job can miss its deadline
+ */
+bool Adafruit_BusIO_RateScheduler::schedulable(void) {
+  float bound = 1.0f;
+  for (uint8_t i = 0; i < _count; i++) {
+    bound *= 1.0f + (float)_jobs[i].worst_us / _jobs[i].deadline_us;
+  }
+  return bound <= 2.0f;
+}
+
+uint32_t Adafruit_BusIO_RateScheduler::_now(void) {
+  return _clock ? _clock() : micros();
+}
+
+// one tick's worth of releases
+void Adafruit_BusIO_RateScheduler::_release(void) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_jobs[i].countdown) {
+      _jobs[i].countdown--;
+      continue;
+    }
+    _jobs[i].countdown = _jobs[i].period - 1;
+    if (_jobs[i].pending) {
+      _jobs[i].misses++; // never got to the last one
+    }
+    _jobs[i].pending = true;
+    _jobs[i].release_us = _next;
+  }
+  _next += _tick_us;
+}
+
+// whether two jobs' registers sit on the same device and get their
+// addresses sent the same way. Only the fields of the device a read goes to
+// are looked at, in the order Adafruit_BusIO_Register::_read() picks it
+bool Adafruit_BusIO_RateScheduler::_sameDevice(uint8_t a, uint8_t b) {
+  Adafruit_BusIO_Register *x = _jobs[a].reg, *y = _jobs[b].reg;
+  if (x == y) {
+    return true;
+  }
+  bool same;
+  if (x->_i2cdevice || y->_i2cdevice) {
+    same = (x->_i2cdevice == y->_i2cdevice);
+  } else if (x->_spidevice || y->_spidevice) {
+    same = (x->_spidevice == y->_spidevice) &&
+           (x->_spiregtype == y->_spiregtype);
+  } else {
+    same = (x->_genericdevice == y->_genericdevice);
+  }
+  return same && (x->_addrwidth == y->_addrwidth) &&
+         (x->_encoder == y->_encoder) && (x->_crc_model == y->_crc_model);
+}
+
+// whether two jobs can be read in one transfer: the same first register, or
+// (with setCoalesce()) registers next to each other
+bool Adafruit_BusIO_RateScheduler::_shares(uint8_t a, uint8_t b) {
+  if (!_sameDevice(a, b)) {
+    return false;
+  }
+  uint16_t x = _jobs[a].reg->_address, y = _jobs[b].reg->_address;
+  if (x == y) {
+    return true;
+  }
+  return _adjacent && !_jobs[a].reg->_crc_model && (x <= y + _jobs[b].len) &&
+         (y <= x + _jobs[a].len);
+}
+
+uint32_t Adafruit_BusIO_RateScheduler::_gcd(uint32_t a, uint32_t b) {
+  while (b) {
+    uint32_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+#endif // SPI exists
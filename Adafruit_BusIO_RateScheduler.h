@@ -0,0 +1,105 @@
+#ifndef Adafruit_BusIO_RateScheduler_h
+#define Adafruit_BusIO_RateScheduler_h
+
+#include <Adafruit_BusIO_Register.h>
+#include <Arduino.h>
+
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+
+#ifndef BUSIO_RATE_JOBS
+#define BUSIO_RATE_JOBS 8 ///< How many periodic reads a scheduler can hold
+#endif
+
+///< Longest run of registers that coalesced reads can cover, in bytes
+#ifndef BUSIO_RATE_SCRATCH
+#define BUSIO_RATE_SCRATCH 32
+#endif
+
+/*!
+ * @brief Called after every periodic read
+ * @param arg The argument given to add()
+ * @param ok True if the read worked
+ * @param release_us When the read was due, on the scheduler's clock
+ */
+typedef void (*busio_rate_done_t)(void *arg, bool ok, uint32_t release_us);
+
+typedef uint32_t (*busio_rate_clock_t)(void); ///< Returns the time in us
+
+/*!
+ * @brief Reads registers at fixed rates (say a 1 kHz IMU, 100 Hz pressure and
+ * 1 Hz temperature) on one shared bus, use one scheduler per bus. Time is cut
+ * into ticks; begin() gives every job a fixed priority (shortest deadline
+ * first, which is rate monotonic when the deadline is the period) and a tick
+ * to start on, picked so jobs collide as little as possible, except reads of
+ * the same registers which are lined up so they share one transfer. service()
+ * does the reads from the main loop, the ticks come from the clock or from a
+ * timer interrupt calling tick().
+ */
+class Adafruit_BusIO_RateScheduler {
+public:
+  Adafruit_BusIO_RateScheduler(uint32_t tick_us = 1000);
+
+  int8_t add(Adafruit_BusIO_Register *reg, uint8_t *buffer, uint8_t len,
+             uint32_t period_us, uint32_t deadline_us = 0,
+             busio_rate_done_t done = nullptr, void *arg = nullptr);
+  bool begin(bool timer = false);
+  void tick(void);
+  bool service(void);
+
+  void setClock(busio_rate_clock_t clock);
+  /*!   @brief  Also read jobs in one go when their registers are next to each
+   *    other (or overlap), not just when they start at the same one. Only for
+   *    devices that step the register address along during a read.
+   *    @param  adjacent True to coalesce neighbouring registers */
+  void setCoalesce(bool adjacent) { _adjacent = adjacent; }
+
+  uint32_t misses(int8_t job = -1);
+  uint32_t worstCost(int8_t job);
+  uint16_t utilization(void);
+  bool schedulable(void);
+  /*!   @brief  How many reads were saved by sharing a transfer
+   *    @return Reads that rode along on another job's transfer */
+  uint32_t coalesced(void) { return _coalesced; }
+  /*!   @brief  How many transfers went out on the bus
+   *    @return Number of transfers since begin() */
+  uint32_t transfers(void) { return _transfers; }
+
+private:
+  struct {
+    Adafruit_BusIO_Register *reg;
+    uint8_t *buffer;
+    uint8_t len;
+    bool pending;
+    uint32_t period;    // in ticks
+    uint32_t countdown; // ticks left until the next release
+    uint32_t deadline_us;
+    uint32_t release_us;
+    busio_rate_done_t done;
+    void *arg;
+    uint32_t misses;
+    uint32_t worst_us;
+  } _jobs[BUSIO_RATE_JOBS];
+  uint8_t _order[BUSIO_RATE_JOBS]; // job indices, highest priority first
+  uint8_t _count = 0;
+
+  uint32_t _tick_us;
+  busio_rate_clock_t _clock = nullptr;
+  bool _timer = false;
+  bool _adjacent = false;
+  volatile uint8_t _ticks = 0;
+  uint32_t _next = 0; // when the next tick is due
+  uint32_t _start = 0;
+  uint32_t _busy_us = 0;
+  uint32_t _coalesced = 0;
+  uint32_t _transfers = 0;
+
+  uint32_t _now(void);
+  void _release(void);
+  bool _sameDevice(uint8_t a, uint8_t b);
+  bool _shares(uint8_t a, uint8_t b);
+  static uint32_t _gcd(uint32_t a, uint32_t b);
+};
+
+#endif // SPI exists
+#endif // Adafruit_BusIO_RateScheduler_h
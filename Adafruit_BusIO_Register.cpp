@@ -1,8 +1,22 @@
+#include <Adafruit_BusIO_Async.h>
 #include <Adafruit_BusIO_Register.h>
 
 #if !defined(SPI_INTERFACES_COUNT) ||                                          \
     (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
 
+// Largest transfer (data plus CRC bytes) when a register has a CRC
+#define BUSIO_REGISTER_CRC_BUFSIZE 48
+
+// Interrupt handlers have to be in RAM on the ESP8266/ESP32
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// Set from the DRDY/INT pin interrupt while a waitFor() is going on. Only
+// one wait runs at a time, so a single flag will do
+static volatile bool busio_wait_irq = false;
+static void IRAM_ATTR busio_wait_isr(void) { busio_wait_irq = true; }
+
 /*!
  *    @brief  Create a register we access over an I2C Device (which defines the
  * bus and address)
@@ -26,6 +40,7 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(Adafruit_I2CDevice *i2cdevice,
   _address = reg_addr;
   _byteorder = byteorder;
   _width = width;
+  _encodeAddress();
 }
 
 /*!
@@ -55,6 +70,7 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(Adafruit_SPIDevice *spidevice,
   _address = reg_addr;
   _byteorder = byteorder;
   _width = width;
+  _encodeAddress();
 }
 
 /*!
@@ -86,6 +102,7 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
   _address = reg_addr;
   _byteorder = byteorder;
   _width = width;
+  _encodeAddress();
 }
 
 /*!
@@ -106,6 +123,7 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
   _address = reg_addr;
   _byteorder = byteorder;
   _width = width;
+  _encodeAddress();
 }
 
 /*!
@@ -116,37 +134,48 @@ Adafruit_BusIO_Register::Adafruit_BusIO_Register(
  * uncheckable)
  */
 bool Adafruit_BusIO_Register::write(uint8_t *buffer, uint8_t len) {
-  uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
-                           (uint8_t)(_address >> 8)};
-  if (_i2cdevice) {
-    return _i2cdevice->write(buffer, len, true, addrbuffer, _addrwidth);
+  if (_cache_ttl) {
+    _cache_len = 0;
   }
-  if (_spidevice) {
-    if (_spiregtype == ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE) {
-      // very special case!
-      // pass the special opcode address which we set as the high byte of the
-      // regaddr
-      addrbuffer[0] =
-          (uint8_t)(_address >> 8) & ~0x01; // set bottom bit low to write
-      // the 'actual' reg addr is the second byte then
-      addrbuffer[1] = (uint8_t)(_address & 0xFF);
-      // the address appears to be a byte longer
-      return _spidevice->write(buffer, len, addrbuffer, _addrwidth + 1);
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOREAD) {
-      addrbuffer[0] &= ~0x80;
+  if (!_crc_model) {
+    if (!_write(buffer, len)) {
+      return false;
     }
-    if (_spiregtype == ADDRBIT8_HIGH_TOWRITE) {
-      addrbuffer[0] |= 0x80;
-    }
-    if (_spiregtype == AD8_HIGH_TOREAD_AD7_HIGH_TOINC) {
-      addrbuffer[0] &= ~0x80;
-      addrbuffer[0] |= 0x40;
+    _cacheStore(buffer, len, false);
+    return true;
+  }
+
+  // put a CRC after every word
+  uint8_t raw[BUSIO_REGISTER_CRC_BUFSIZE];
+  Adafruit_BusIO_CRC crc(_crc_model);
+  uint8_t pos = 0;
+  for (uint8_t i = 0; i < len; i += _crc_word) {
+    uint8_t n = ((len - i) < _crc_word) ? (len - i) : _crc_word;
+    if ((size_t)(pos + n + crc.size()) > sizeof(raw)) {
+      return false;
     }
-    return _spidevice->write(buffer, len, addrbuffer, _addrwidth);
+    memcpy(raw + pos, buffer + i, n);
+    crc.reset();
+    crc.update(buffer + i, n);
+    crc.put(raw + pos + n);
+    pos += n + crc.size();
+  }
+  if (!_write(raw, pos)) {
+    return false;
+  }
+  _cacheStore(buffer, len, false);
+  return true;
+}
+
+bool Adafruit_BusIO_Register::_write(uint8_t *buffer, uint8_t len) {
+  if (_i2cdevice) {
+    return _i2cdevice->write(buffer, len, true, _wraddr, _wraddrlen);
+  }
+  if (_spidevice) {
+    return _spidevice->write(buffer, len, _wraddr, _wraddrlen);
   }
   if (_genericdevice) {
-    return _genericdevice->writeRegister(addrbuffer, _addrwidth, buffer, len);
+    return _genericdevice->writeRegister(_wraddr, _wraddrlen, buffer, len);
   }
   return false;
 }
@@ -189,7 +218,13 @@ uint32_t Adafruit_BusIO_Register::read(void) {
   if (!read(_buffer, _width)) {
     return -1;
   }
+  return _value();
+}
 
+/*
+ * Put together the value of the register from the bytes in _buffer
+ */
+uint32_t Adafruit_BusIO_Register::_value(void) {
   uint32_t value = 0;
 
   for (int i = 0; i < _width; i++) {
@@ -217,37 +252,56 @@ uint32_t Adafruit_BusIO_Register::readCached(void) { return _cached; }
    @return true on successful read, otherwise false
 */
 bool Adafruit_BusIO_Register::read(uint8_t *buffer, uint8_t len) {
-  uint8_t addrbuffer[2] = {(uint8_t)(_address & 0xFF),
-                           (uint8_t)(_address >> 8)};
-  if (_i2cdevice) {
-    return _i2cdevice->write_then_read(addrbuffer, _addrwidth, buffer, len);
-  }
-  if (_spidevice) {
-    if (_spiregtype == ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE) {
-      // very special case!
-      // pass the special opcode address which we set as the high byte of the
-      // regaddr
-      addrbuffer[0] =
-          (uint8_t)(_address >> 8) | 0x01; // set bottom bit high to read
-      // the 'actual' reg addr is the second byte then
-      addrbuffer[1] = (uint8_t)(_address & 0xFF);
-      // the address appears to be a byte longer
-      return _spidevice->write_then_read(addrbuffer, _addrwidth + 1, buffer,
-                                         len);
-    }
-    if (_spiregtype == ADDRBIT8_HIGH_TOREAD) {
-      addrbuffer[0] |= 0x80;
+  if (_cache_ttl) {
+    if (_cache_len && (_cache_len == len) &&
+        ((micros() - _cache_time) < _cache_ttl)) {
+      memcpy(buffer, _cache, len);
+      _cache_hits++;
+      return true;
     }
-    if (_spiregtype == ADDRBIT8_HIGH_TOWRITE) {
-      addrbuffer[0] &= ~0x80;
+    _cache_misses++;
+    _cache_len = 0;
+  }
+  if (!_crc_model) {
+    if (!_read(buffer, len)) {
+      return false;
     }
-    if (_spiregtype == AD8_HIGH_TOREAD_AD7_HIGH_TOINC) {
-      addrbuffer[0] |= 0x80 | 0x40;
+    _cacheStore(buffer, len, true);
+    return true;
+  }
+
+  // every word comes with a CRC after it, check and strip them
+  uint8_t raw[BUSIO_REGISTER_CRC_BUFSIZE];
+  Adafruit_BusIO_CRC crc(_crc_model);
+  uint8_t words = (len + _crc_word - 1) / _crc_word;
+  size_t raw_len = len + (size_t)words * crc.size();
+  if (raw_len > sizeof(raw) || !_read(raw, raw_len)) {
+    return false;
+  }
+  uint8_t *p = raw;
+  for (uint8_t i = 0; i < len; i += _crc_word) {
+    uint8_t n = ((len - i) < _crc_word) ? (len - i) : _crc_word;
+    crc.reset();
+    crc.update(p, n);
+    if (!crc.check(p + n)) {
+      return false;
     }
-    return _spidevice->write_then_read(addrbuffer, _addrwidth, buffer, len);
+    memcpy(buffer + i, p, n);
+    p += n + crc.size();
+  }
+  _cacheStore(buffer, len, true);
+  return true;
+}
+
+bool Adafruit_BusIO_Register::_read(uint8_t *buffer, uint8_t len) {
+  if (_i2cdevice) {
+    return _i2cdevice->write_then_read(_rdaddr, _rdaddrlen, buffer, len);
+  }
+  if (_spidevice) {
+    return _spidevice->write_then_read(_rdaddr, _rdaddrlen, buffer, len);
   }
   if (_genericdevice) {
-    return _genericdevice->readRegister(addrbuffer, _addrwidth, buffer, len);
+    return _genericdevice->readRegister(_rdaddr, _rdaddrlen, buffer, len);
   }
   return false;
 }
@@ -275,6 +329,48 @@ bool Adafruit_BusIO_Register::read(uint16_t *value) {
   return true;
 }
 
+/*!
+ *    @brief  Read the whole register (up to 4 bytes), telling failure apart
+ * from a register that reads as 0xFFFFFFFF
+ *    @param  value Pointer to uint32_t variable to read into
+ *    @return True on successful read
+ */
+bool Adafruit_BusIO_Register::read(uint32_t *value) {
+  if (!read(_buffer, _width)) {
+    return false;
+  }
+  *value = _value();
+  return true;
+}
+
+/*!
+ *    @brief  Queue up a read of this register, see Adafruit_BusIO_AsyncQueue
+ *    @param  queue The queue to run the read from
+ *    @param  done Optional function to call with the value
+ *    @param  arg Passed to done as is
+ *    @return Handle to check on the read with, -1 if the queue is full
+ */
+busio_async_handle_t
+Adafruit_BusIO_Register::readAsync(Adafruit_BusIO_AsyncQueue *queue,
+                                   busio_async_done_t done, void *arg) {
+  return queue->read(this, done, arg);
+}
+
+/*!
+ *    @brief  Queue up a write of this register, see Adafruit_BusIO_AsyncQueue
+ *    @param  queue The queue to run the write from
+ *    @param  value The value to write
+ *    @param  done Optional function to call once written
+ *    @param  arg Passed to done as is
+ *    @return Handle to check on the write with, -1 if the queue is full
+ */
+busio_async_handle_t
+Adafruit_BusIO_Register::writeAsync(Adafruit_BusIO_AsyncQueue *queue,
+                                    uint32_t value, busio_async_done_t done,
+                                    void *arg) {
+  return queue->write(this, value, done, arg);
+}
+
 /*!
  *    @brief  Read 1 byte of data from the register location
  *    @param  value Pointer to uint8_t variable to read into
@@ -323,6 +419,37 @@ Adafruit_BusIO_RegisterBits::Adafruit_BusIO_RegisterBits(
   _shift = shift;
 }
 
+/*!
+ *    @brief  Wait for the slice of bits to read as a given value, e.g. a
+ * 'data ready' bit to go to 1. See Adafruit_BusIO_Register::waitFor()
+ *    @param  value The value to wait for, not shifted
+ *    @param  timeout_us How long to wait at most, in microseconds
+ *    @param  stats Optional place to put how long it took and how many polls
+ *    @return True if the bits got to the value before the timeout
+ */
+bool Adafruit_BusIO_RegisterBits::waitFor(uint32_t value, uint32_t timeout_us,
+                                          busio_register_waitstats_t *stats) {
+  uint32_t mask = (1 << (_bits)) - 1;
+  return _register->waitFor(mask << _shift, (value & mask) << _shift,
+                            timeout_us, stats);
+}
+
+/*!
+ *    @brief  Queue up a read-modify-write of these bits, see
+ * Adafruit_BusIO_AsyncQueue
+ *    @param  queue The queue to run the write from
+ *    @param  value The value to put in the bits, not shifted
+ *    @param  done Optional function to call once written
+ *    @param  arg Passed to done as is
+ *    @return Handle to check on the write with, -1 if the queue is full
+ */
+busio_async_handle_t
+Adafruit_BusIO_RegisterBits::writeAsync(Adafruit_BusIO_AsyncQueue *queue,
+                                        uint32_t value,
+                                        busio_async_done_t done, void *arg) {
+  return queue->write(this, value, done, arg);
+}
+
 /*!
  *    @brief  Read 4 bytes of data from the register
  *    @return  data The 4 bytes to read
@@ -359,11 +486,27 @@ bool Adafruit_BusIO_RegisterBits::write(uint32_t data) {
  */
 uint8_t Adafruit_BusIO_Register::width(void) { return _width; }
 
+/*!
+ *    @brief  Why the last access to this register failed, when it lives on an
+ *    I2C device. Timeouts and retries are set on the Adafruit_I2CDevice.
+ *    @returns The error of the device's last transaction, BUSIO_I2C_OK for
+ *    SPI and generic devices
+ */
+Adafruit_BusIO_I2CError Adafruit_BusIO_Register::lastError(void) {
+  if (_i2cdevice) {
+    return _i2cdevice->lastError();
+  }
+  return BUSIO_I2C_OK;
+}
+
 /*!
  *    @brief  Set the default width of data
  *    @param width the default width of data read from register
  */
-void Adafruit_BusIO_Register::setWidth(uint8_t width) { _width = width; }
+void Adafruit_BusIO_Register::setWidth(uint8_t width) {
+  _width = width;
+  _cache_len = 0;
+}
 
 /*!
  *    @brief  Set register address
@@ -371,6 +514,7 @@ void Adafruit_BusIO_Register::setWidth(uint8_t width) { _width = width; }
  */
 void Adafruit_BusIO_Register::setAddress(uint16_t address) {
   _address = address;
+  _encodeAddress();
 }
 
 /*!
@@ -379,6 +523,215 @@ void Adafruit_BusIO_Register::setAddress(uint16_t address) {
  */
 void Adafruit_BusIO_Register::setAddressWidth(uint16_t address_width) {
   _addrwidth = address_width;
+  _encodeAddress();
+}
+
+/*!
+ *    @brief  Use a custom function to turn the register address into the
+ * bytes sent before a read or a write, for devices the SPI register types
+ * don't cover (e.g. a 16-bit command word, or an R/W flag in bit 0). It is
+ * called right away and whenever the address changes, never per access
+ *    @param  encoder The encoder, or nullptr to go back to the built-in one
+ */
+void Adafruit_BusIO_Register::setAddressEncoder(
+    busio_register_encoder_t encoder) {
+  _encoder = encoder;
+  _encodeAddress();
+}
+
+/*
+ * Work out the address bytes for reads and writes once, so an access is a
+ * single call into the device
+ */
+void Adafruit_BusIO_Register::_encodeAddress(void) {
+  _cache_len = 0; // what is cached came from the old address
+  if (_encoder) {
+    _rdaddrlen = _encoder(_address, false, _rdaddr);
+    _wraddrlen = _encoder(_address, true, _wraddr);
+    return;
+  }
+
+  _rdaddr[0] = _wraddr[0] = _address & 0xFF;
+  _rdaddr[1] = _wraddr[1] = _address >> 8;
+  _rdaddrlen = _wraddrlen = (_addrwidth > 2) ? 2 : _addrwidth;
+  if (!_spidevice || _i2cdevice) {
+    return;
+  }
+
+  switch (_spiregtype) {
+  case ADDRBIT8_HIGH_TOREAD:
+    _rdaddr[0] |= 0x80;
+    _wraddr[0] &= ~0x80;
+    break;
+  case AD8_HIGH_TOREAD_AD7_HIGH_TOINC:
+    _rdaddr[0] |= 0x80 | 0x40;
+    _wraddr[0] = (_wraddr[0] & ~0x80) | 0x40;
+    break;
+  case ADDRBIT8_HIGH_TOWRITE:
+    _rdaddr[0] &= ~0x80;
+    _wraddr[0] |= 0x80;
+    break;
+  case ADDRESSED_OPCODE_BIT0_LOW_TO_WRITE:
+    // very special case! the high byte of the address is the opcode, which
+    // goes first with its bottom bit set to read, cleared to write. The
+    // 'actual' register address follows, so the address is a byte longer
+    _rdaddr[0] = (uint8_t)(_address >> 8) | 0x01;
+    _wraddr[0] = (uint8_t)(_address >> 8) & ~0x01;
+    _rdaddr[1] = _wraddr[1] = _address & 0xFF;
+    _rdaddrlen = _wraddrlen = _addrwidth + 1;
+    break;
+  }
+}
+
+/*!
+ *    @brief  Protect the register data with a CRC after every word, the way
+ * Sensirion (and similar) sensors do: each word read is checked and the CRC
+ * stripped off, each word written gets one added. Reads with a bad CRC fail.
+ *    @param  model Which CRC the device uses, e.g. &busio_crc8_sensirion, or
+ * nullptr to turn it off again
+ *    @param  word_size How many data bytes each CRC covers
+ */
+void Adafruit_BusIO_Register::setCRC(const busio_crc_model_t *model,
+                                     uint8_t word_size) {
+  _crc_model = model;
+  _crc_word = word_size ? word_size : 1;
+}
+
+/*!
+ *    @brief  Let reads of this register be answered from the last value for a
+ * while, rather than going out on the bus every time. Handy for status
+ * registers on slow transports that get looked at many times per loop, and
+ * shared by every RegisterBits slice of this register. Reads of up to 4 bytes
+ * are cached. Note that a RegisterBits write() reads the register first, so
+ * it may work from a cached value.
+ *    @param  ttl_us How long a value read from the device stays good, in
+ * microseconds. 0 turns caching off (the default, for volatile registers)
+ *    @param  invalidate_on_write True to drop the cached value on a write,
+ * false to cache the value that was written instead
+ */
+void Adafruit_BusIO_Register::setReadCache(uint32_t ttl_us,
+                                           bool invalidate_on_write) {
+  _cache_ttl = ttl_us;
+  _cache_invalidate = invalidate_on_write;
+  _cache_len = 0;
+  _cache_hits = _cache_misses = 0;
+}
+
+/*!
+ *    @brief  Forget the cached value, so the next read goes out on the bus.
+ * Call this when something else (e.g. a reset) may have changed the register
+ */
+void Adafruit_BusIO_Register::invalidateCache(void) { _cache_len = 0; }
+
+/*
+ * Remember a value that was just read from, or written to, the register
+ */
+void Adafruit_BusIO_Register::_cacheStore(const uint8_t *buffer, uint8_t len,
+                                          bool from_read) {
+  if (!_cache_ttl || (len > sizeof(_cache)) ||
+      (!from_read && _cache_invalidate)) {
+    return;
+  }
+  memcpy(_cache, buffer, len);
+  _cache_len = len;
+  _cache_time = micros();
+}
+
+/*!
+ *    @brief  Wait for some bits of the register to read as a given value, such
+ * as a 'data ready' or 'busy' flag. Rather than reading in a tight loop, the
+ * time between polls doubles from the minimum to the maximum interval (see
+ * setWaitInterval()), which leaves the bus free for other devices during
+ * long conversions. With setWaitPin(), an edge on the device's DRDY/INT pin
+ * cuts the current interval short. Reads never come from the read cache.
+ *    @param  mask Which bits to look at
+ *    @param  value What those bits should read as
+ *    @param  timeout_us How long to wait at most, in microseconds
+ *    @param  stats Optional place to put how long it took and how many polls
+ *    @return True if the bits got to the value before the timeout
+ */
+bool Adafruit_BusIO_Register::waitFor(uint32_t mask, uint32_t value,
+                                      uint32_t timeout_us,
+                                      busio_register_waitstats_t *stats) {
+  uint32_t start = micros();
+  uint32_t interval = _wait_min_us;
+  uint16_t polls = 0;
+  bool done = false;
+
+  int irq = (_wait_pin >= 0) ? (int)digitalPinToInterrupt(_wait_pin) : -1;
+#ifdef NOT_AN_INTERRUPT
+  if (irq == NOT_AN_INTERRUPT) {
+    irq = -1; // the pin can't interrupt, just poll
+  }
+#endif
+  if (irq >= 0) {
+    attachInterrupt(irq, busio_wait_isr, _wait_mode);
+  }
+
+  for (;;) {
+    busio_wait_irq = false; // an edge from here on means something changed
+    invalidateCache();
+    polls++;
+    if (read(_buffer, _width) && ((_value() & mask) == (value & mask))) {
+      done = true;
+      break;
+    }
+
+    uint32_t elapsed = micros() - start;
+    if (elapsed >= timeout_us) {
+      break;
+    }
+    uint32_t wait = timeout_us - elapsed;
+    if (wait > interval) {
+      wait = interval;
+    }
+    uint32_t t = micros();
+    while (!busio_wait_irq && ((micros() - t) < wait)) {
+      yield();
+    }
+    if (interval < _wait_max_us) {
+      interval *= 2;
+      if (interval > _wait_max_us) {
+        interval = _wait_max_us;
+      }
+    }
+  }
+
+  if (irq >= 0) {
+    detachInterrupt(irq);
+  }
+  if (stats) {
+    stats->wait_us = micros() - start;
+    stats->polls = polls;
+    stats->timed_out = !done;
+  }
+  return done;
+}
+
+/*!
+ *    @brief  Set how often waitFor() polls the register. It starts at the
+ * minimum and doubles after every poll until it hits the maximum
+ *    @param  min_us Time between the first polls, in microseconds
+ *    @param  max_us Longest time between polls, in microseconds
+ */
+void Adafruit_BusIO_Register::setWaitInterval(uint16_t min_us,
+                                              uint16_t max_us) {
+  _wait_min_us = min_us ? min_us : 1;
+  _wait_max_us = (max_us > _wait_min_us) ? max_us : _wait_min_us;
+}
+
+/*!
+ *    @brief  Use the device's DRDY/INT pin to wake waitFor() up as soon as
+ * something changes, instead of only at the next poll. A pin that can't
+ * interrupt is polled as usual. waitFor() attaches its own handler for the
+ * wait and detaches it afterwards, so the pin must not have one already
+ * (from an Adafruit_BusIO_Sampler or attachInterrupt()), it would be lost
+ *    @param  pin The Arduino pin the DRDY/INT line is on, -1 for none
+ *    @param  mode Which edge to wake up on: RISING, FALLING or CHANGE
+ */
+void Adafruit_BusIO_Register::setWaitPin(int8_t pin, int mode) {
+  _wait_pin = pin;
+  _wait_mode = mode;
 }
 
 #endif // SPI exists
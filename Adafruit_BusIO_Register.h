@@ -6,6 +6,7 @@
 #if !defined(SPI_INTERFACES_COUNT) ||                                          \
     (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
 
+#include <Adafruit_BusIO_CRC.h>
 #include <Adafruit_GenericDevice.h>
 #include <Adafruit_I2CDevice.h>
 #include <Adafruit_SPIDevice.h>
@@ -37,6 +38,44 @@ typedef enum _Adafruit_BusIO_SPIRegType {
 
 } Adafruit_BusIO_SPIRegType;
 
+///< Most bytes an address encoder may produce
+#define BUSIO_REGISTER_MAX_PREFIX 4
+
+/*!
+ * @brief Turns a register address into the bytes sent ahead of the data
+ * @param address The register address
+ * @param write True for the prefix of a write, false for a read
+ * @param buffer Where to put up to BUSIO_REGISTER_MAX_PREFIX bytes
+ * @return How many bytes were put in the buffer
+ */
+typedef uint8_t (*busio_register_encoder_t)(uint16_t address, bool write,
+                                            uint8_t *buffer);
+
+/*!
+ * @brief Where a queued register access is at
+ */
+typedef enum _busio_async_state {
+  BUSIO_ASYNC_FREE = 0, ///< Descriptor not in use
+  BUSIO_ASYNC_QUEUED,   ///< Waiting its turn
+  BUSIO_ASYNC_DONE,     ///< Finished, the value is ready
+  BUSIO_ASYNC_FAILED,   ///< The device did not answer
+} busio_async_state_t;
+
+typedef void (*busio_async_done_t)(void *arg, bool ok, uint32_t value);
+
+typedef int8_t busio_async_handle_t; ///< Index of a queued access, -1 if none
+
+class Adafruit_BusIO_AsyncQueue;
+
+/*!
+ * @brief How a waitFor() went, for tuning poll intervals
+ */
+typedef struct {
+  uint32_t wait_us; ///< How long the wait took, in microseconds
+  uint16_t polls;   ///< How many times the register was read
+  bool timed_out;   ///< True if the register never got to the value
+} busio_register_waitstats_t;
+
 /*!
  * @brief The class which defines a device register (a location to read/write
  * data from)
@@ -66,16 +105,42 @@ public:
   bool read(uint8_t *buffer, uint8_t len);
   bool read(uint8_t *value);
   bool read(uint16_t *value);
+  bool read(uint32_t *value);
   uint32_t read(void);
   uint32_t readCached(void);
   bool write(uint8_t *buffer, uint8_t len);
   bool write(uint32_t value, uint8_t numbytes = 0);
 
+  busio_async_handle_t readAsync(Adafruit_BusIO_AsyncQueue *queue,
+                                 busio_async_done_t done = nullptr,
+                                 void *arg = nullptr);
+  busio_async_handle_t writeAsync(Adafruit_BusIO_AsyncQueue *queue,
+                                  uint32_t value,
+                                  busio_async_done_t done = nullptr,
+                                  void *arg = nullptr);
+
   uint8_t width(void);
+  Adafruit_BusIO_I2CError lastError(void);
 
   void setWidth(uint8_t width);
   void setAddress(uint16_t address);
   void setAddressWidth(uint16_t address_width);
+  void setAddressEncoder(busio_register_encoder_t encoder);
+  void setCRC(const busio_crc_model_t *model, uint8_t word_size = 2);
+
+  void setReadCache(uint32_t ttl_us, bool invalidate_on_write = true);
+  void invalidateCache(void);
+  /*!   @brief  How many reads were answered from the read cache
+   *    @return Cache hits since setReadCache() */
+  uint32_t cacheHits(void) { return _cache_hits; }
+  /*!   @brief  How many reads had to go out on the bus with the cache on
+   *    @return Cache misses since setReadCache() */
+  uint32_t cacheMisses(void) { return _cache_misses; }
+
+  bool waitFor(uint32_t mask, uint32_t value, uint32_t timeout_us,
+               busio_register_waitstats_t *stats = nullptr);
+  void setWaitInterval(uint16_t min_us, uint16_t max_us);
+  void setWaitPin(int8_t pin, int mode = RISING);
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SERIAL)
   void print(Stream *s = &Serial);
@@ -86,6 +151,8 @@ public:
 #endif
 
 private:
+  friend class Adafruit_BusIO_RateScheduler; // coalesces reads by address
+
   Adafruit_I2CDevice *_i2cdevice;
   Adafruit_SPIDevice *_spidevice;
   Adafruit_GenericDevice *_genericdevice;
@@ -95,6 +162,29 @@ private:
   uint8_t _buffer[4]; // we won't support anything larger than uint32 for
                       // non-buffered read
   uint32_t _cached = 0;
+  busio_register_encoder_t _encoder = nullptr;
+  uint8_t _rdaddr[BUSIO_REGISTER_MAX_PREFIX]; // address bytes sent to read
+  uint8_t _wraddr[BUSIO_REGISTER_MAX_PREFIX]; // and to write
+  uint8_t _rdaddrlen, _wraddrlen;
+  const busio_crc_model_t *_crc_model = nullptr;
+  uint8_t _crc_word = 2;
+
+  uint32_t _cache_ttl = 0; // 0 is volatile, never cached
+  uint32_t _cache_time = 0;
+  uint32_t _cache_hits = 0, _cache_misses = 0;
+  uint8_t _cache[4];
+  uint8_t _cache_len = 0; // 0 if nothing is cached
+  bool _cache_invalidate = true;
+
+  uint16_t _wait_min_us = 10, _wait_max_us = 1000;
+  int8_t _wait_pin = -1;
+  int _wait_mode = RISING;
+
+  bool _read(uint8_t *buffer, uint8_t len);
+  bool _write(uint8_t *buffer, uint8_t len);
+  void _cacheStore(const uint8_t *buffer, uint8_t len, bool from_read);
+  uint32_t _value(void);
+  void _encodeAddress(void);
 };
 
 /*!
@@ -107,6 +197,12 @@ public:
                               uint8_t shift);
   bool write(uint32_t value);
   uint32_t read(void);
+  bool waitFor(uint32_t value, uint32_t timeout_us,
+               busio_register_waitstats_t *stats = nullptr);
+  busio_async_handle_t writeAsync(Adafruit_BusIO_AsyncQueue *queue,
+                                  uint32_t value,
+                                  busio_async_done_t done = nullptr,
+                                  void *arg = nullptr);
 
 private:
   Adafruit_BusIO_Register *_register;
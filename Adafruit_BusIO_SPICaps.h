@@ -0,0 +1,79 @@
+#ifndef Adafruit_BusIO_SPICaps_h
+#define Adafruit_BusIO_SPICaps_h
+
+// What the core's SPIClass can move in one call, so Adafruit_SPIDevice can
+// pick the fastest way instead of going a byte at a time. Include after
+// <SPI.h>.
+
+#define BUSIO_SPI_CAP_INPLACE 0x01 ///< BUSIO_SPI_INPLACE(spi, buf, len)
+#define BUSIO_SPI_CAP_DUPLEX 0x02  ///< BUSIO_SPI_DUPLEX(spi, tx, rx, len)
+#define BUSIO_SPI_CAP_TXONLY 0x04  ///< BUSIO_SPI_TXONLY(spi, tx, len)
+#define BUSIO_SPI_CAP_DMA 0x10     ///< BUSIO_SPI_TXSTART(spi, tx, len, done)
+#define BUSIO_SPI_CAP_PATTERN 0x20 ///< BUSIO_SPI_PATTERN(spi, tx, len, count)
+
+// BUSIO_SPI_TXSTART starts sending in the background and calls the
+// void (*done)(void) passed to it, possibly from an interrupt, once finished.
+
+// BUSIO_SPI_PATTERN sends tx count times over, for tx up to
+// BUSIO_SPI_PATTERN_MAX bytes long.
+
+// Define BUSIO_SPI_CAPS, and a macro for every capability it claims, to
+// override the table below (e.g. to try out other combinations on the host)
+#ifndef BUSIO_SPI_CAPS
+
+#if defined(SPARK)
+#define BUSIO_SPI_CAPS                                                         \
+  (BUSIO_SPI_CAP_INPLACE | BUSIO_SPI_CAP_DUPLEX | BUSIO_SPI_CAP_TXONLY |       \
+   BUSIO_SPI_CAP_DMA)
+#define BUSIO_SPI_INPLACE(spi, buf, len)                                       \
+  (spi)->transfer(buf, buf, len, nullptr)
+#define BUSIO_SPI_DUPLEX(spi, tx, rx, len)                                     \
+  (spi)->transfer((void *)(tx), rx, len, nullptr)
+#define BUSIO_SPI_TXONLY(spi, tx, len)                                         \
+  (spi)->transfer((void *)(tx), nullptr, len, nullptr)
+#define BUSIO_SPI_TXSTART(spi, tx, len, done)                                  \
+  (spi)->transfer((void *)(tx), nullptr, len, done)
+
+#elif defined(ARDUINO_ARCH_ESP32)
+#define BUSIO_SPI_CAPS                                                         \
+  (BUSIO_SPI_CAP_INPLACE | BUSIO_SPI_CAP_DUPLEX | BUSIO_SPI_CAP_TXONLY |       \
+   BUSIO_SPI_CAP_PATTERN)
+#define BUSIO_SPI_INPLACE(spi, buf, len) (spi)->transfer(buf, len)
+#define BUSIO_SPI_DUPLEX(spi, tx, rx, len)                                     \
+  (spi)->transferBytes((uint8_t *)(tx), rx, len)
+#define BUSIO_SPI_TXONLY(spi, tx, len) (spi)->writeBytes((uint8_t *)(tx), len)
+#define BUSIO_SPI_PATTERN(spi, tx, len, count)                                 \
+  (spi)->writePattern((uint8_t *)(tx), len, count)
+#define BUSIO_SPI_PATTERN_MAX 64
+
+#elif defined(STM32)
+#if defined(SPI_TRANSMITONLY)
+// the buffer is left alone when the receive is skipped
+#define BUSIO_SPI_CAPS (BUSIO_SPI_CAP_INPLACE | BUSIO_SPI_CAP_TXONLY)
+#define BUSIO_SPI_INPLACE(spi, buf, len) (spi)->transfer(buf, len)
+#define BUSIO_SPI_TXONLY(spi, tx, len)                                         \
+  (spi)->transfer((void *)(tx), len, SPI_TRANSMITONLY)
+#elif defined(STM32_CORE_VERSION) && (STM32_CORE_VERSION >= 0x02000000)
+// 2.x cores before skip-receive still do a whole buffer in place
+#define BUSIO_SPI_CAPS BUSIO_SPI_CAP_INPLACE
+#define BUSIO_SPI_INPLACE(spi, buf, len) (spi)->transfer(buf, len)
+#else
+// older cores only take a buffer along with a CS pin
+#define BUSIO_SPI_CAPS 0
+#endif
+
+#else
+#define BUSIO_SPI_CAPS BUSIO_SPI_CAP_INPLACE
+#define BUSIO_SPI_INPLACE(spi, buf, len) (spi)->transfer(buf, len)
+#endif
+
+#endif // BUSIO_SPI_CAPS
+
+// Cores whose SPI peripheral can't shift LSB first and quietly send MSB first
+// instead. Adafruit_SPIDevice then sends MSB first and reverses the bits of
+// every byte itself. Define it in the build flags for other such cores.
+#if !defined(BUSIO_SPI_NO_LSBFIRST) && defined(ARDUINO_ARCH_MBED_RP2040)
+#define BUSIO_SPI_NO_LSBFIRST
+#endif
+
+#endif // Adafruit_BusIO_SPICaps_h
@@ -0,0 +1,177 @@
+#include "Adafruit_BusIO_Sampler.h"
+
+// Interrupt handlers have to be in RAM on the ESP8266/ESP32
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+Adafruit_BusIO_Sampler *Adafruit_BusIO_Sampler::_slots[BUSIO_SAMPLER_SLOTS];
+
+// attachInterrupt() has no user pointer, so each slot gets its own trampoline
+void (*const Adafruit_BusIO_Sampler::_isrs[BUSIO_SAMPLER_SLOTS])(void) = {
+    _isr0, _isr1};
+
+/*!
+ *    @brief  Create a sampler that reads a block of registers over I2C
+ *    @param  i2cdevice The I2CDevice the sensor is on
+ *    @param  reg_addr The address of the first register in the block
+ *    @param  address_width The width of the register address, 1 or 2 bytes
+ */
+Adafruit_BusIO_Sampler::Adafruit_BusIO_Sampler(Adafruit_I2CDevice *i2cdevice,
+                                               uint16_t reg_addr,
+                                               uint8_t address_width) {
+  _i2cdevice = i2cdevice;
+  _addrbuffer[0] = reg_addr & 0xFF;
+  _addrbuffer[1] = reg_addr >> 8;
+  _addrwidth = address_width;
+}
+
+/*!
+ *    @brief  Create a sampler that reads a block of registers over SPI
+ *    @param  spidevice The SPIDevice the sensor is on
+ *    @param  reg_addr The address to send before reading, including any
+ * read/auto-increment bits the sensor wants (e.g. 0x80 | 0x40 | reg)
+ *    @param  address_width The width of the register address, 1 or 2 bytes
+ */
+Adafruit_BusIO_Sampler::Adafruit_BusIO_Sampler(Adafruit_SPIDevice *spidevice,
+                                               uint16_t reg_addr,
+                                               uint8_t address_width) {
+  _spidevice = spidevice;
+  _addrbuffer[0] = reg_addr & 0xFF;
+  _addrbuffer[1] = reg_addr >> 8;
+  _addrwidth = address_width;
+}
+
+/*!
+ *    @brief  Detach the interrupt, if there is one
+ */
+Adafruit_BusIO_Sampler::~Adafruit_BusIO_Sampler() { end(); }
+
+/*!
+ *    @brief  Start sampling
+ *    @param  buffer0 One of the two sample buffers, len bytes long
+ *    @param  buffer1 The other sample buffer, len bytes long
+ *    @param  len How many bytes to read per sample
+ *    @param  drdy_pin The pin the sensor's DRDY/INT line is on, or -1 to
+ * call trigger() yourself (from your own interrupt, or a timer)
+ *    @param  mode Which edge means new data: RISING, FALLING or CHANGE
+ *    @return False if a pin was given but all interrupt slots are taken
+ */
+bool Adafruit_BusIO_Sampler::begin(uint8_t *buffer0, uint8_t *buffer1,
+                                   size_t len, int8_t drdy_pin, int mode) {
+  end();
+  _buffers[0] = buffer0;
+  _buffers[1] = buffer1;
+  _len = len;
+  _held = 1;
+  _pending = false;
+  _overruns = 0;
+  _triggers = 0;
+
+  if (drdy_pin < 0) {
+    return true;
+  }
+  for (uint8_t i = 0; i < BUSIO_SAMPLER_SLOTS; i++) {
+    if (!_slots[i]) {
+      _slots[i] = this;
+      _slot = i;
+      _pin = drdy_pin;
+      pinMode(_pin, INPUT);
+      attachInterrupt(digitalPinToInterrupt(_pin), _isrs[i], mode);
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ *    @brief  Stop sampling and let go of the interrupt
+ */
+void Adafruit_BusIO_Sampler::end(void) {
+  if (_slot >= 0) {
+    detachInterrupt(digitalPinToInterrupt(_pin));
+    _slots[_slot] = nullptr;
+    _slot = -1;
+    _pin = -1;
+  }
+}
+
+/*!
+ *    @brief  Note that the sensor has new data. Called from the DRDY
+ * interrupt, safe to call from your own interrupt handler
+ */
+void IRAM_ATTR Adafruit_BusIO_Sampler::trigger(void) {
+  _trigger_time = micros();
+  if (_triggers < 255) {
+    _triggers++;
+  }
+}
+
+/*!
+ *    @brief  Read the sample the last trigger asked for, if there is one.
+ * Call this often from the main loop
+ *    @return True if a sample was read
+ */
+bool Adafruit_BusIO_Sampler::service(void) {
+  noInterrupts();
+  uint8_t triggers = _triggers;
+  uint32_t time = _trigger_time;
+  _triggers = 0;
+  interrupts();
+
+  if (!triggers || !_len) {
+    return false;
+  }
+  // only the newest sample is still in the sensor
+  _overruns += triggers - 1;
+
+  uint8_t fill = _held ^ 1;
+  bool ok = false;
+  if (_i2cdevice) {
+    ok = _i2cdevice->write_then_read(_addrbuffer, _addrwidth, _buffers[fill],
+                                     _len);
+  } else if (_spidevice) {
+    ok = _spidevice->write_then_read(_addrbuffer, _addrwidth, _buffers[fill],
+                                     _len);
+  }
+  if (!ok) {
+    return false;
+  }
+
+  if (_pending) {
+    _overruns++; // the one that was waiting just got written over
+  }
+  _times[fill] = time;
+  _pending = true;
+  return true;
+}
+
+/*!
+ *    @brief  Get the newest sample. The buffer is ours until the next call to
+ * take(), the sampler fills the other one in the meantime
+ *    @param  timestamp Optional place to put the micros() at the trigger
+ *    @return Pointer to the sample, or nullptr if there is nothing new
+ */
+const uint8_t *Adafruit_BusIO_Sampler::take(uint32_t *timestamp) {
+  if (!_pending) {
+    return nullptr;
+  }
+  _pending = false;
+  _held ^= 1;
+  if (timestamp) {
+    *timestamp = _times[_held];
+  }
+  return _buffers[_held];
+}
+
+void IRAM_ATTR Adafruit_BusIO_Sampler::_isr0(void) {
+  if (_slots[0]) {
+    _slots[0]->trigger();
+  }
+}
+
+void IRAM_ATTR Adafruit_BusIO_Sampler::_isr1(void) {
+  if (_slots[1]) {
+    _slots[1]->trigger();
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef Adafruit_BusIO_Sampler_h
+#define Adafruit_BusIO_Sampler_h
+
+#include <Adafruit_I2CDevice.h>
+#include <Adafruit_SPIDevice.h>
+#include <Arduino.h>
+
+///< How many samplers can have a DRDY interrupt attached at the same time
+#define BUSIO_SAMPLER_SLOTS 2
+
+/*!
+ * @brief Reads a block of registers every time a sensor says it has new data,
+ * into one of two buffers that take turns (ping-pong), so the main loop can
+ * look at one sample while the next one is being read. The DRDY interrupt
+ * only takes a timestamp, the bus transfer happens in service() since most
+ * cores can't do I2C/SPI from an interrupt.
+ */
+class Adafruit_BusIO_Sampler {
+public:
+  Adafruit_BusIO_Sampler(Adafruit_I2CDevice *i2cdevice, uint16_t reg_addr,
+                         uint8_t address_width = 1);
+  Adafruit_BusIO_Sampler(Adafruit_SPIDevice *spidevice, uint16_t reg_addr,
+                         uint8_t address_width = 1);
+  ~Adafruit_BusIO_Sampler();
+
+  bool begin(uint8_t *buffer0, uint8_t *buffer1, size_t len,
+             int8_t drdy_pin = -1, int mode = RISING);
+  void end(void);
+
+  void trigger(void);
+  bool service(void);
+  const uint8_t *take(uint32_t *timestamp = nullptr);
+
+  /*!   @brief  How many samples were lost, because they were never take()n
+   *    before the next one came in, or service() fell behind the interrupts
+   *    @return Number of lost samples since begin() */
+  uint32_t overruns(void) { return _overruns; }
+
+private:
+  Adafruit_I2CDevice *_i2cdevice = nullptr;
+  Adafruit_SPIDevice *_spidevice = nullptr;
+  uint8_t _addrbuffer[2];
+  uint8_t _addrwidth;
+
+  uint8_t *_buffers[2] = {nullptr, nullptr};
+  size_t _len = 0;
+  uint32_t _times[2] = {0, 0};
+  uint8_t _held = 1;     // the buffer the consumer has, we fill the other one
+  bool _pending = false; // a filled buffer is waiting to be taken
+  uint32_t _overruns = 0;
+
+  int8_t _pin = -1;
+  int8_t _slot = -1;
+  volatile uint8_t _triggers = 0;
+  volatile uint32_t _trigger_time = 0;
+
+  static Adafruit_BusIO_Sampler *_slots[BUSIO_SAMPLER_SLOTS];
+  static void (*const _isrs[BUSIO_SAMPLER_SLOTS])(void);
+  static void _isr0(void);
+  static void _isr1(void);
+};
+
+#endif // Adafruit_BusIO_Sampler_h
@@ -0,0 +1,161 @@
+#include "Adafruit_BusIO_Script.h"
+
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+
+/*!
+ *    @brief  Create a script player for an I2C device
+ *    @param  i2cdevice The I2CDevice to play scripts on
+ *    @param  address_width The width of the register addresses, in bytes
+ */
+Adafruit_BusIO_Script::Adafruit_BusIO_Script(Adafruit_I2CDevice *i2cdevice,
+                                             uint8_t address_width)
+    : _reg(i2cdevice, 0, 1, LSBFIRST, address_width) {}
+
+/*!
+ *    @brief  Create a script player for an SPI device
+ *    @param  spidevice The SPIDevice to play scripts on
+ *    @param  type How the read/write bit is put in the register address
+ *    @param  address_width The width of the register addresses, in bytes
+ */
+Adafruit_BusIO_Script::Adafruit_BusIO_Script(Adafruit_SPIDevice *spidevice,
+                                             Adafruit_BusIO_SPIRegType type,
+                                             uint8_t address_width)
+    : _reg(spidevice, 0, type, 1, LSBFIRST, address_width) {}
+
+/*!
+ *    @brief  Create a script player for a generic device
+ *    @param  genericdevice The GenericDevice to play scripts on
+ *    @param  address_width The width of the register addresses, in bytes
+ */
+Adafruit_BusIO_Script::Adafruit_BusIO_Script(
+    Adafruit_GenericDevice *genericdevice, uint8_t address_width)
+    : _reg(genericdevice, 0, 1, LSBFIRST, address_width) {}
+
+/*!
+ *    @brief  Play a script, stopping at the first step that fails
+ *    @param  script The script, in PROGMEM, ending with BUSIO_SCRIPT_END
+ *    @return True if every step went through
+ */
+bool Adafruit_BusIO_Script::run(const uint8_t *script) {
+  uint8_t page = 0;
+  _pos = 0;
+  _transactions = 0;
+
+  for (;;) {
+    const uint8_t *p = script + _pos;
+    uint8_t op = pgm_read_byte(p);
+    uint16_t address = 0;
+    uint8_t mask = 0, value = 0, current;
+    if ((op == BUSIO_SCRIPT_OP_UPDATE) || (op == BUSIO_SCRIPT_OP_WAIT) ||
+        (op == BUSIO_SCRIPT_OP_VERIFY)) {
+      address = ((uint16_t)page << 8) | pgm_read_byte(p + 1);
+      mask = pgm_read_byte(p + 2);
+      value = pgm_read_byte(p + 3);
+    }
+
+    switch (op) {
+    case BUSIO_SCRIPT_OP_END:
+      return true;
+
+    case BUSIO_SCRIPT_OP_WRITE:
+      if (!_write(script, page)) {
+        return false;
+      }
+      break;
+
+    case BUSIO_SCRIPT_OP_UPDATE:
+      if (!_readByte(address, &current)) {
+        return false;
+      }
+      current = (current & ~mask) | (value & mask);
+      _transactions++;
+      if (!_reg.write(current, 1)) {
+        return false;
+      }
+      _pos += 4;
+      break;
+
+    case BUSIO_SCRIPT_OP_DELAY:
+      delay(pgm_read_byte(p + 1) | ((uint16_t)pgm_read_byte(p + 2) << 8));
+      _pos += 3;
+      break;
+
+    case BUSIO_SCRIPT_OP_WAIT: {
+      uint32_t timeout_ms =
+          pgm_read_byte(p + 4) | ((uint16_t)pgm_read_byte(p + 5) << 8);
+      busio_register_waitstats_t stats;
+      _reg.setAddress(address);
+      bool ok = _reg.waitFor(mask, value, timeout_ms * 1000, &stats);
+      _transactions += stats.polls;
+      if (!ok) {
+        return false;
+      }
+      _pos += 6;
+      break;
+    }
+
+    case BUSIO_SCRIPT_OP_VERIFY:
+      if (!_readByte(address, &current) || ((current & mask) != value)) {
+        return false;
+      }
+      _pos += 4;
+      break;
+
+    case BUSIO_SCRIPT_OP_PAGE:
+      page = pgm_read_byte(p + 1);
+      _pos += 2;
+      break;
+
+    default:
+      return false;
+    }
+  }
+}
+
+/*!
+ *    @brief  Play the write at _pos, along with the ones right after it that
+ *    carry on at the next register, if bursts are on
+ *    @param  script The script
+ *    @param  page Upper register address byte
+ *    @return True if the write went through
+ */
+bool Adafruit_BusIO_Script::_write(const uint8_t *script, uint8_t page) {
+  uint8_t buffer[BUSIO_SCRIPT_BURST];
+  uint16_t pos = _pos;
+  uint8_t reg = pgm_read_byte(script + pos + 1);
+  uint8_t len = 0;
+
+  do {
+    const uint8_t *p = script + pos;
+    uint8_t n = pgm_read_byte(p + 2);
+    if (len && ((pgm_read_byte(p) != BUSIO_SCRIPT_OP_WRITE) ||
+                (pgm_read_byte(p + 1) != (uint8_t)(reg + len)) ||
+                ((uint16_t)reg + len > 0xFF) ||
+                ((len + n) > sizeof(buffer)))) {
+      break;
+    }
+    if (n > sizeof(buffer)) {
+      return false;
+    }
+    memcpy_P(buffer + len, p + 3, n);
+    len += n;
+    pos += 3 + n;
+  } while (_burst);
+
+  _reg.setAddress(((uint16_t)page << 8) | reg);
+  _transactions++;
+  if (!_reg.write(buffer, len)) {
+    return false;
+  }
+  _pos = pos;
+  return true;
+}
+
+bool Adafruit_BusIO_Script::_readByte(uint16_t address, uint8_t *value) {
+  _reg.setAddress(address);
+  _transactions++;
+  return _reg.read(value);
+}
+
+#endif // SPI exists
@@ -0,0 +1,105 @@
+#ifndef Adafruit_BusIO_Script_h
+#define Adafruit_BusIO_Script_h
+
+#include <Adafruit_BusIO_Register.h>
+#include <Arduino.h>
+
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+
+///< Most bytes merged into one burst write
+#ifndef BUSIO_SCRIPT_BURST
+#define BUSIO_SCRIPT_BURST 32
+#endif
+
+/*!
+ * @brief Script opcodes, use the BUSIO_SCRIPT_ macros rather than these
+ */
+typedef enum _busio_script_op {
+  BUSIO_SCRIPT_OP_END = 0, ///< End of the script
+  BUSIO_SCRIPT_OP_WRITE,   ///< reg, len, data...
+  BUSIO_SCRIPT_OP_UPDATE,  ///< reg, mask, value
+  BUSIO_SCRIPT_OP_DELAY,   ///< ms low byte, ms high byte
+  BUSIO_SCRIPT_OP_WAIT,    ///< reg, mask, value, timeout ms low, high
+  BUSIO_SCRIPT_OP_VERIFY,  ///< reg, mask, value
+  BUSIO_SCRIPT_OP_PAGE,    ///< upper register address byte
+} busio_script_op_t;
+
+/// @cond
+#define BUSIO_SCRIPT_NARGS(...)                                                \
+  BUSIO_SCRIPT_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5,  \
+                      4, 3, 2, 1)
+#define BUSIO_SCRIPT_NARGS_(a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, \
+                            a13, a14, a15, a16, n, ...)                        \
+  n
+/// @endcond
+
+///< Write 1 to 16 bytes starting at a register
+#define BUSIO_SCRIPT_WRITE(reg, ...)                                           \
+  BUSIO_SCRIPT_OP_WRITE, (reg), BUSIO_SCRIPT_NARGS(__VA_ARGS__), __VA_ARGS__
+///< Read a register, change the bits in mask to value, write it back
+#define BUSIO_SCRIPT_UPDATE(reg, mask, value)                                  \
+  BUSIO_SCRIPT_OP_UPDATE, (reg), (mask), (value)
+///< Wait a number of milliseconds, up to 65535
+#define BUSIO_SCRIPT_DELAY(ms)                                                 \
+  BUSIO_SCRIPT_OP_DELAY, ((ms) & 0xFF), (((ms) >> 8) & 0xFF)
+///< Poll a register until (reg & mask) == value, fail after timeout ms
+#define BUSIO_SCRIPT_WAIT(reg, mask, value, timeout_ms)                        \
+  BUSIO_SCRIPT_OP_WAIT, (reg), (mask), (value), ((timeout_ms) & 0xFF),         \
+      (((timeout_ms) >> 8) & 0xFF)
+///< Read a register, fail unless (reg & mask) == value, e.g. a chip ID
+#define BUSIO_SCRIPT_VERIFY(reg, mask, value)                                  \
+  BUSIO_SCRIPT_OP_VERIFY, (reg), (mask), (value)
+///< Set the upper byte of the register addresses that follow
+#define BUSIO_SCRIPT_PAGE(page) BUSIO_SCRIPT_OP_PAGE, (page)
+///< End of the script
+#define BUSIO_SCRIPT_END BUSIO_SCRIPT_OP_END
+
+/*!
+ * @brief Plays an init sequence stored in flash, so drivers can swap a page of
+ * register write calls for a table, e.g.
+ *
+ *     static const uint8_t init[] PROGMEM = {
+ *       BUSIO_SCRIPT_VERIFY(0x0F, 0xFF, 0x33),
+ *       BUSIO_SCRIPT_WRITE(0x20, 0x57, 0x00, 0x00, 0x88),
+ *       BUSIO_SCRIPT_DELAY(10),
+ *       BUSIO_SCRIPT_END};
+ *
+ * Writes to consecutive registers can be merged into one burst, for devices
+ * that auto-increment the register address.
+ */
+class Adafruit_BusIO_Script {
+public:
+  Adafruit_BusIO_Script(Adafruit_I2CDevice *i2cdevice,
+                        uint8_t address_width = 1);
+  Adafruit_BusIO_Script(Adafruit_SPIDevice *spidevice,
+                        Adafruit_BusIO_SPIRegType type,
+                        uint8_t address_width = 1);
+  Adafruit_BusIO_Script(Adafruit_GenericDevice *genericdevice,
+                        uint8_t address_width = 1);
+
+  bool run(const uint8_t *script);
+
+  /*!   @brief  Merge writes to consecutive registers into one write, for
+   *    devices that auto-increment the register address
+   *    @param  enable True to merge */
+  void setBurst(bool enable) { _burst = enable; }
+  /*!   @brief  Where the last run() stopped
+   *    @return Offset of the step that failed, or of the end of the script */
+  uint16_t position(void) { return _pos; }
+  /*!   @brief  How many transactions the last run() made
+   *    @return Number of register reads and writes */
+  uint16_t transactions(void) { return _transactions; }
+
+private:
+  Adafruit_BusIO_Register _reg;
+  bool _burst = false;
+  uint16_t _pos = 0;
+  uint16_t _transactions = 0;
+
+  bool _write(const uint8_t *script, uint8_t page);
+  bool _readByte(uint16_t address, uint8_t *value);
+};
+
+#endif // SPI exists
+#endif // Adafruit_BusIO_Script_h
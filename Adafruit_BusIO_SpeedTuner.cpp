@@ -0,0 +1,125 @@
+#include "Adafruit_BusIO_SpeedTuner.h"
+#include "Adafruit_BusIO_Register.h"
+
+/*!
+ *    @brief  Create the bookkeeping for one device
+ *    @param  floor The slowest clock to back off to until a calibration sets
+ *    its own minimum, in Hz, e.g. 100KHz for I2C
+ */
+Adafruit_BusIO_SpeedTuner::Adafruit_BusIO_SpeedTuner(uint32_t floor) {
+  _floor = floor;
+}
+
+/*!
+ *    @brief  The next clock to try while calibrating, 25% above the last
+ *    @param  freq The clock that just passed, in Hz
+ *    @return The clock to try next, in Hz
+ */
+uint32_t Adafruit_BusIO_SpeedTuner::step(uint32_t freq) {
+  return freq + (freq / 4) + 1;
+}
+
+/*!
+ *    @brief  Read a register with a known value a few times in a row. Every
+ *    read goes out on the bus, past the register's read cache, and none of
+ *    them count towards the error backoff
+ *    @param  reg The register to read, usually an ID/WHOAMI register
+ *    @param  expected The value the register must read back as
+ *    @param  reads How many reads in a row must match
+ *    @return True if every read matched
+ */
+bool Adafruit_BusIO_SpeedTuner::verify(Adafruit_BusIO_Register *reg,
+                                       uint32_t expected, uint8_t reads) {
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+  bool ok = true;
+  _verifying = true;
+  for (uint8_t i = 0; ok && (i < reads); i++) {
+    reg->invalidateCache();
+    ok = (reg->read() == expected);
+  }
+  _verifying = false;
+  return ok;
+#else
+  (void)reg;
+  (void)expected;
+  (void)reads;
+  return false;
+#endif
+}
+
+/*!
+ *    @brief  Turn the fastest passing clock into the one we actually use, by
+ *    taking a safety margin off it (but never going under the minimum)
+ *    @param  min_freq The slowest clock that was tried, in Hz
+ *    @param  best The fastest clock that passed, 0 if none did
+ *    @param  margin_pct How many percent to take off the fastest clock
+ *    @return The clock to run at, 0 if calibration failed
+ */
+uint32_t Adafruit_BusIO_SpeedTuner::settle(uint32_t min_freq, uint32_t best,
+                                           uint8_t margin_pct) {
+  if (!best) {
+    return 0;
+  }
+  if (margin_pct > 100) {
+    margin_pct = 100;
+  }
+  uint32_t freq = best - (best / 100) * margin_pct;
+  if (freq < min_freq) {
+    freq = min_freq;
+  }
+  _calibrated = freq;
+  _floor = min_freq;
+  _count = _errors = 0;
+  return freq;
+}
+
+/*!
+ *    @brief  Slow the clock down by a step when too many transactions fail
+ *    @param  max_errors How many failures within the window trigger a step
+ *    down, 0 to never back off
+ *    @param  window How many transactions make up the window
+ */
+void Adafruit_BusIO_SpeedTuner::setBackoff(uint8_t max_errors,
+                                           uint8_t window) {
+  _max_errors = max_errors;
+  _window = window;
+  _count = _errors = 0;
+}
+
+/*!
+ *    @brief  Turn a transaction already counted by record() into a failure,
+ *    e.g. one whose data turned out bad. The window only closes on the next
+ *    record()
+ */
+void Adafruit_BusIO_SpeedTuner::fail(void) {
+  if (!_verifying && (_errors < _window)) {
+    _errors++;
+  }
+}
+
+/*!
+ *    @brief  Count a transaction towards the error rate
+ *    @param  ok Whether the transaction went through
+ *    @param  freq The clock it ran at, in Hz
+ *    @return The clock to drop down to, or 0 to stay at the current one
+ */
+uint32_t Adafruit_BusIO_SpeedTuner::record(bool ok, uint32_t freq) {
+  if (!_max_errors || !_window || _verifying) {
+    return 0;
+  }
+  if (!ok) {
+    _errors++;
+  }
+  if (++_count < _window) {
+    return 0;
+  }
+
+  bool slow_down = (_errors >= _max_errors);
+  _count = _errors = 0;
+  if (!slow_down || (freq <= _floor)) {
+    return 0;
+  }
+  freq -= freq / 4;
+  return (freq < _floor) ? _floor : freq;
+}
@@ -0,0 +1,36 @@
+#ifndef Adafruit_BusIO_SpeedTuner_h
+#define Adafruit_BusIO_SpeedTuner_h
+
+#include <Arduino.h>
+
+class Adafruit_BusIO_Register;
+
+/*!
+ * @brief Bookkeeping for finding the fastest clock a device works at, and for
+ * backing off at runtime when errors start to pile up. Used by the I2C and SPI
+ * devices, which own the actual clock.
+ */
+class Adafruit_BusIO_SpeedTuner {
+public:
+  Adafruit_BusIO_SpeedTuner(uint32_t floor);
+
+  uint32_t step(uint32_t freq);
+  bool verify(Adafruit_BusIO_Register *reg, uint32_t expected, uint8_t reads);
+  uint32_t settle(uint32_t min_freq, uint32_t best, uint8_t margin_pct);
+  void setBackoff(uint8_t max_errors, uint8_t window);
+  uint32_t record(bool ok, uint32_t freq);
+  void fail(void);
+
+  /*!   @brief  The speed picked by the last calibration
+   *    @return The calibrated clock in Hz, 0 if never calibrated */
+  uint32_t calibrated(void) { return _calibrated; }
+
+private:
+  uint32_t _calibrated = 0;
+  uint32_t _floor;
+  bool _verifying = false; // calibration reads don't count towards backoff
+  uint8_t _max_errors = 0, _window = 0;
+  uint8_t _count = 0, _errors = 0;
+};
+
+#endif // Adafruit_BusIO_SpeedTuner_h
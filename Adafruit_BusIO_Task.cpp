@@ -0,0 +1,82 @@
+#include "Adafruit_BusIO_Task.h"
+#include "Adafruit_BusIO_Async.h"
+
+/*!
+ *    @brief  Create a scheduler with no tasks
+ */
+Adafruit_BusIO_Scheduler::Adafruit_BusIO_Scheduler(void) {
+  for (uint8_t i = 0; i < BUSIO_SCHEDULER_TASKS; i++) {
+    _tasks[i].func = nullptr;
+  }
+  _active = 0;
+  _queue = nullptr;
+}
+
+/*!
+ *    @brief  Start a task, it first runs on the next pass
+ *    @param  func The task function
+ *    @param  arg Passed to the task as is, usually its state struct
+ *    @return False if the scheduler is full
+ */
+bool Adafruit_BusIO_Scheduler::add(busio_task_func_t func, void *arg) {
+  for (uint8_t i = 0; i < BUSIO_SCHEDULER_TASKS; i++) {
+    if (!_tasks[i].func) {
+      _tasks[i].func = func;
+      _tasks[i].arg = arg;
+      _tasks[i].pt.line = 0;
+      _tasks[i].pt.wake = 0;
+      _tasks[i].state = BUSIO_TASK_READY;
+      _active++;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ *    @brief  Have every pass also run one access from an async queue, for
+ * tasks that BUSIO_PT_AWAIT() queued register accesses
+ *    @param  queue The queue, or nullptr for none
+ */
+void Adafruit_BusIO_Scheduler::setQueue(Adafruit_BusIO_AsyncQueue *queue) {
+  _queue = queue;
+}
+
+/*!
+ *    @brief  Run every task that is ready (or whose sleep is over) once. Call
+ * this from the main loop
+ *    @return True while there are tasks left
+ */
+bool Adafruit_BusIO_Scheduler::run(void) {
+#if !defined(SPI_INTERFACES_COUNT) ||                                          \
+    (defined(SPI_INTERFACES_COUNT) && (SPI_INTERFACES_COUNT > 0))
+  if (_queue) {
+    _queue->poll();
+  }
+#endif
+
+  for (uint8_t i = 0; i < BUSIO_SCHEDULER_TASKS; i++) {
+    if (!_tasks[i].func) {
+      continue;
+    }
+    if ((_tasks[i].state == BUSIO_TASK_SLEEPING) &&
+        ((int32_t)(micros() - _tasks[i].pt.wake) < 0)) {
+      continue;
+    }
+    _tasks[i].state = _tasks[i].func(&_tasks[i].pt, _tasks[i].arg);
+    if (_tasks[i].state == BUSIO_TASK_DONE) {
+      _tasks[i].func = nullptr;
+      _active--;
+    }
+  }
+  return _active != 0;
+}
+
+/*!
+ *    @brief  Keep running passes until every task has finished
+ */
+void Adafruit_BusIO_Scheduler::runAll(void) {
+  while (run()) {
+    yield();
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef Adafruit_BusIO_Task_h
+#define Adafruit_BusIO_Task_h
+
+#include <Arduino.h>
+
+class Adafruit_BusIO_AsyncQueue;
+
+/*!
+ * @brief What a task said when it gave the CPU back
+ */
+typedef enum _busio_task_state {
+  BUSIO_TASK_READY = 0, ///< Run me again on the next pass
+  BUSIO_TASK_SLEEPING,  ///< Don't run me before my wake time
+  BUSIO_TASK_DONE,      ///< Finished, take me off the scheduler
+} busio_task_state_t;
+
+/*!
+ * @brief Where a task is at, kept between calls. Tasks are stackless: any
+ * local variable that has to survive a wait belongs in the task's arg
+ */
+typedef struct {
+  uint16_t line; ///< Where to pick up again, 0 at the start
+  uint32_t wake; ///< micros() to sleep until, while sleeping
+} busio_pt_t;
+
+typedef busio_task_state_t (*busio_task_func_t)(busio_pt_t *pt, void *arg);
+
+/*!
+ * @brief Task body markers (protothread style). A task function looks like
+ *
+ *     busio_task_state_t readTemp(busio_pt_t *pt, void *arg) {
+ *       BUSIO_PT_BEGIN(pt);
+ *       startConversion();
+ *       BUSIO_PT_SLEEP_US(pt, 10000); // other tasks run meanwhile
+ *       readResult();
+ *       BUSIO_PT_END(pt);
+ *     }
+ *
+ * No switch statements of your own between BEGIN and END, the markers use one
+ */
+#define BUSIO_PT_BEGIN(pt)                                                     \
+  switch ((pt)->line) {                                                        \
+  case 0:
+///< End of a task body, the task is done when it gets here
+#define BUSIO_PT_END(pt)                                                       \
+  }                                                                            \
+  (pt)->line = 0;                                                              \
+  return BUSIO_TASK_DONE
+///< Let other tasks run, then carry on
+#define BUSIO_PT_YIELD(pt)                                                     \
+  do {                                                                         \
+    (pt)->line = __LINE__;                                                     \
+    return BUSIO_TASK_READY;                                                   \
+  case __LINE__:;                                                              \
+  } while (0)
+///< Let other tasks run until cond is true
+#define BUSIO_PT_WAIT_UNTIL(pt, cond)                                          \
+  do {                                                                         \
+    (pt)->line = __LINE__;                                                     \
+  case __LINE__:                                                               \
+    if (!(cond))                                                               \
+      return BUSIO_TASK_READY;                                                 \
+  } while (0)
+///< Let other tasks run for a while, e.g. during a conversion
+#define BUSIO_PT_SLEEP_US(pt, us)                                              \
+  do {                                                                         \
+    (pt)->wake = micros() + (us);                                              \
+    (pt)->line = __LINE__;                                                     \
+  case __LINE__:                                                               \
+    if ((int32_t)(micros() - (pt)->wake) < 0)                                  \
+      return BUSIO_TASK_SLEEPING;                                              \
+  } while (0)
+///< Let other tasks run until cond is true, checking it every interval_us
+#define BUSIO_PT_POLL_UNTIL(pt, cond, interval_us)                             \
+  do {                                                                         \
+    (pt)->line = __LINE__;                                                     \
+  case __LINE__:                                                               \
+    if (!(cond)) {                                                             \
+      (pt)->wake = micros() + (interval_us);                                   \
+      return BUSIO_TASK_SLEEPING;                                              \
+    }                                                                          \
+  } while (0)
+///< Wait for an access queued on an Adafruit_BusIO_AsyncQueue to finish
+#define BUSIO_PT_AWAIT(pt, queue, handle)                                      \
+  BUSIO_PT_WAIT_UNTIL(pt, (queue)->state(handle) != BUSIO_ASYNC_QUEUED)
+
+#ifndef BUSIO_SCHEDULER_TASKS
+#define BUSIO_SCHEDULER_TASKS 8 ///< How many tasks a scheduler can hold
+#endif
+
+/*!
+ * @brief Runs tasks round-robin, skipping the ones that are asleep, so one
+ * device's conversion delay or ACK polling overlaps other devices' traffic
+ */
+class Adafruit_BusIO_Scheduler {
+public:
+  Adafruit_BusIO_Scheduler(void);
+
+  bool add(busio_task_func_t func, void *arg = nullptr);
+  void setQueue(Adafruit_BusIO_AsyncQueue *queue);
+  bool run(void);
+  void runAll(void);
+  /*!   @brief  How many tasks have not finished yet
+   *    @return Number of tasks on the scheduler */
+  uint8_t active(void) { return _active; }
+
+private:
+  struct {
+    busio_task_func_t func;
+    void *arg;
+    busio_pt_t pt;
+    busio_task_state_t state;
+  } _tasks[BUSIO_SCHEDULER_TASKS];
+  uint8_t _active;
+  Adafruit_BusIO_AsyncQueue *_queue;
+};
+
+#endif // Adafruit_BusIO_Task_h
@@ -5,6 +5,7 @@
 */
 
 #include "Adafruit_GenericDevice.h"
+#include "Adafruit_BusIO_Capture.h"
 
 /*!
  * @brief Create a Generic device with the provided read/write functions
@@ -49,7 +50,18 @@ void Adafruit_GenericDevice::end(void) { _begun = false; }
 bool Adafruit_GenericDevice::write(const uint8_t *buffer, size_t len) {
   if (!_begun)
     return false;
-  return _write_func(_obj, buffer, len);
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_GENERIC, BUSIO_CAPTURE_WRITE, 0, nullptr, 0,
+                      buffer, len, nullptr, 0);
+  if (!_frame_crc)
+    return BUSIO_CAPTURE_END(_write_func(_obj, buffer, len));
+
+  uint8_t crcbuf[4];
+  Adafruit_BusIO_CRC crc(_frame_crc);
+  crc.update(buffer, len);
+  crc.put(crcbuf);
+  busio_genericdevice_iovec_t iov[2] = {{(uint8_t *)buffer, len},
+                                        {crcbuf, crc.size()}};
+  return BUSIO_CAPTURE_END(writev(iov, 2));
 }
 
 /*! @brief Read data into a buffer
@@ -59,7 +71,18 @@ bool Adafruit_GenericDevice::write(const uint8_t *buffer, size_t len) {
 bool Adafruit_GenericDevice::read(uint8_t *buffer, size_t len) {
   if (!_begun)
     return false;
-  return _read_func(_obj, buffer, len);
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_GENERIC, BUSIO_CAPTURE_READ, 0, nullptr, 0,
+                      nullptr, 0, buffer, len);
+  if (!_frame_crc)
+    return BUSIO_CAPTURE_END(_read_func(_obj, buffer, len));
+
+  uint8_t crcbuf[4];
+  Adafruit_BusIO_CRC crc(_frame_crc);
+  busio_genericdevice_iovec_t iov[2] = {{buffer, len}, {crcbuf, crc.size()}};
+  if (!readv(iov, 2))
+    return BUSIO_CAPTURE_END(false);
+  crc.update(buffer, len);
+  return BUSIO_CAPTURE_END(crc.check(crcbuf));
 }
 
 /*! @brief Read from a register location
@@ -72,7 +95,9 @@ bool Adafruit_GenericDevice::readRegister(uint8_t *addr_buf, uint8_t addrsiz,
                                           uint8_t *buf, uint16_t bufsiz) {
   if (!_begun || !_readreg_func)
     return false;
-  return _readreg_func(_obj, addr_buf, addrsiz, buf, bufsiz);
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_GENERIC, BUSIO_CAPTURE_READ_REGISTER, 0,
+                      addr_buf, addrsiz, nullptr, 0, buf, bufsiz);
+  return BUSIO_CAPTURE_END(_readreg_func(_obj, addr_buf, addrsiz, buf, bufsiz));
 }
 
 /*! @brief Write to a register location
@@ -86,5 +111,188 @@ bool Adafruit_GenericDevice::writeRegister(uint8_t *addr_buf, uint8_t addrsiz,
                                            uint16_t bufsiz) {
   if (!_begun || !_writereg_func)
     return false;
-  return _writereg_func(_obj, addr_buf, addrsiz, buf, bufsiz);
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_GENERIC, BUSIO_CAPTURE_WRITE_REGISTER, 0,
+                      addr_buf, addrsiz, buf, bufsiz, nullptr, 0);
+  return BUSIO_CAPTURE_END(
+      _writereg_func(_obj, addr_buf, addrsiz, buf, bufsiz));
+}
+
+/*! @brief Hook up optional functions that move several buffers or registers
+   in one go, e.g. so a UART transport can pack them into a single frame.
+   Anything left nullptr falls back to one call per piece.
+   @param readv_func Function pointer for a scatter read
+   @param writev_func Function pointer for a gather write
+   @param regbatch_func Function pointer for a batch of register accesses */
+void Adafruit_GenericDevice::setBatchFunctions(
+    busio_genericdevice_readv_t readv_func,
+    busio_genericdevice_writev_t writev_func,
+    busio_genericdevice_regbatch_t regbatch_func) {
+  _readv_func = readv_func;
+  _writev_func = writev_func;
+  _regbatch_func = regbatch_func;
+}
+
+/*! @brief Read into several buffers, one after the other
+   @param iov Array of buffers to fill
+   @param iovcnt Number of buffers in the array
+   @return true if every read was successful, otherwise false */
+bool Adafruit_GenericDevice::readv(const busio_genericdevice_iovec_t *iov,
+                                   uint8_t iovcnt) {
+  if (!_begun)
+    return false;
+  if (_readv_func)
+    return _readv_func(_obj, iov, iovcnt);
+  for (uint8_t i = 0; i < iovcnt; i++) {
+    if (!_read_func(_obj, iov[i].buffer, iov[i].len))
+      return false;
+  }
+  return true;
+}
+
+/*! @brief Write several buffers, one after the other
+   @param iov Array of buffers to write
+   @param iovcnt Number of buffers in the array
+   @return true if every write was successful, otherwise false */
+bool Adafruit_GenericDevice::writev(const busio_genericdevice_iovec_t *iov,
+                                    uint8_t iovcnt) {
+  if (!_begun)
+    return false;
+  if (_writev_func)
+    return _writev_func(_obj, iov, iovcnt);
+  for (uint8_t i = 0; i < iovcnt; i++) {
+    if (!_write_func(_obj, iov[i].buffer, iov[i].len))
+      return false;
+  }
+  return true;
+}
+
+/*! @brief Read and/or write several registers, in order
+   @param ops Array of register accesses
+   @param count Number of accesses in the array
+   @return true if every access was successful, otherwise false */
+bool Adafruit_GenericDevice::transferRegisters(
+    busio_genericdevice_regop_t *ops, uint8_t count) {
+  if (!_begun)
+    return false;
+  if (_regbatch_func)
+    return _regbatch_func(_obj, ops, count);
+  for (uint8_t i = 0; i < count; i++) {
+    bool ok = ops[i].write ? writeRegister(ops[i].addr_buf, ops[i].addrsiz,
+                                           ops[i].data, ops[i].datalen)
+                           : readRegister(ops[i].addr_buf, ops[i].addrsiz,
+                                          ops[i].data, ops[i].datalen);
+    if (!ok)
+      return false;
+  }
+  return true;
+}
+
+/*! @brief Hook up a function that says how many bytes can be read without
+   blocking (e.g. Stream::available()), which is what lets beginRead()/poll()
+   pick up bytes as they trickle in
+   @param available_func Function pointer returning the number of bytes ready */
+void Adafruit_GenericDevice::setAvailableFunction(
+    busio_genericdevice_available_t available_func) {
+  _available_func = available_func;
+}
+
+/*! @brief Start reading into a buffer without blocking. Call poll() until it
+   says the read is no longer busy, or let the callback tell you. Without an
+   available function the read is done right here, blocking.
+   @param buffer Pointer to buffer to read data into, must stay valid until
+   the read is over
+   @param len Number of bytes to read
+   @param timeout_us How long the whole read may take, in microseconds
+   @param done_func Optional function called once the read is over
+   @param done_arg Argument handed to done_func
+   @return true if the read was started, false if one is already going on */
+bool Adafruit_GenericDevice::beginRead(uint8_t *buffer, size_t len,
+                                       uint32_t timeout_us,
+                                       busio_genericdevice_done_t done_func,
+                                       void *done_arg) {
+  if (!_begun || (_async_state == BUSIO_READ_BUSY))
+    return false;
+
+  _async_buf = buffer;
+  _async_len = len;
+  _async_pos = 0;
+  _async_start = micros();
+  _async_timeout = timeout_us;
+  _done_func = done_func;
+  _done_arg = done_arg;
+  _async_state = BUSIO_READ_BUSY;
+
+  if (!_available_func) {
+    _finishRead(_read_func(_obj, buffer, len) ? BUSIO_READ_DONE
+                                              : BUSIO_READ_ERROR);
+  } else {
+    poll();
+  }
+  return true;
+}
+
+/*! @brief Move a read started with beginRead() along: grab whatever bytes
+   have arrived and check the deadline. Never blocks.
+   @return The state of the read */
+busio_genericdevice_readstate_t Adafruit_GenericDevice::poll(void) {
+  if (_async_state != BUSIO_READ_BUSY)
+    return _async_state;
+
+  int avail = _available_func(_obj);
+  if (avail > 0) {
+    size_t chunk = _async_len - _async_pos;
+    if ((size_t)avail < chunk)
+      chunk = avail;
+    if (!_read_func(_obj, _async_buf + _async_pos, chunk))
+      return _finishRead(BUSIO_READ_ERROR);
+    _async_pos += chunk;
+  }
+
+  if (_async_pos >= _async_len)
+    return _finishRead(BUSIO_READ_DONE);
+  if ((micros() - _async_start) >= _async_timeout)
+    return _finishRead(BUSIO_READ_TIMEOUT);
+  return BUSIO_READ_BUSY;
+}
+
+/*! @brief Give up on a read started with beginRead(), without calling the
+   callback. Bytes already read stay in the buffer. */
+void Adafruit_GenericDevice::cancelRead(void) {
+  _async_state = BUSIO_READ_IDLE;
+}
+
+/*! @brief Read data into a buffer, returning as soon as the last byte is in
+   rather than polling on a millisecond delay
+   @param buffer Pointer to buffer to read data into
+   @param len Number of bytes to read
+   @param timeout_us How long to wait for all the bytes, in microseconds
+   @return true if all bytes were read in time, otherwise false */
+bool Adafruit_GenericDevice::readTimeout(uint8_t *buffer, size_t len,
+                                         uint32_t timeout_us) {
+  if (!beginRead(buffer, len, timeout_us))
+    return false;
+
+  busio_genericdevice_readstate_t state;
+  while ((state = poll()) == BUSIO_READ_BUSY) {
+    yield();
+  }
+  return state == BUSIO_READ_DONE;
+}
+
+busio_genericdevice_readstate_t
+Adafruit_GenericDevice::_finishRead(busio_genericdevice_readstate_t state) {
+  _async_state = state;
+  if (_done_func)
+    _done_func(_done_arg, state == BUSIO_READ_DONE);
+  return state;
+}
+
+/*! @brief Protect every read() and write() frame with a CRC: it is sent
+   right after the data on a write, and read and checked right after the data
+   on a read (a mismatch fails the read). Register access is left to the
+   register functions, which know their own framing.
+   @param model Which CRC to use, e.g. &busio_crc16_modbus, or nullptr to
+   turn it off again */
+void Adafruit_GenericDevice::setFrameCRC(const busio_crc_model_t *model) {
+  _frame_crc = model;
 }
@@ -1,6 +1,7 @@
 #ifndef ADAFRUIT_GENERICDEVICE_H
 #define ADAFRUIT_GENERICDEVICE_H
 
+#include <Adafruit_BusIO_CRC.h>
 #include <Arduino.h>
 
 typedef bool (*busio_genericdevice_read_t)(void *obj, uint8_t *buffer,
@@ -15,6 +16,45 @@ typedef bool (*busio_genericdevice_writereg_t)(void *obj, uint8_t *addr_buf,
                                                const uint8_t *data,
                                                uint16_t datalen);
 
+/*!
+ * @brief One piece of a scatter/gather transfer
+ */
+typedef struct {
+  uint8_t *buffer; ///< Data to write from, or read into
+  size_t len;      ///< Number of bytes in this piece
+} busio_genericdevice_iovec_t;
+
+/*!
+ * @brief One register access in a batch
+ */
+typedef struct {
+  uint8_t *addr_buf; ///< Buffer containing the register address
+  uint8_t addrsiz;   ///< Size of the register address in bytes
+  uint8_t *data;     ///< Data to write from, or read into
+  uint16_t datalen;  ///< Size of the data in bytes
+  bool write;        ///< True to write the register, false to read it
+} busio_genericdevice_regop_t;
+
+typedef bool (*busio_genericdevice_readv_t)(
+    void *obj, const busio_genericdevice_iovec_t *iov, uint8_t iovcnt);
+typedef bool (*busio_genericdevice_writev_t)(
+    void *obj, const busio_genericdevice_iovec_t *iov, uint8_t iovcnt);
+typedef bool (*busio_genericdevice_regbatch_t)(
+    void *obj, busio_genericdevice_regop_t *ops, uint8_t count);
+typedef int (*busio_genericdevice_available_t)(void *obj);
+typedef void (*busio_genericdevice_done_t)(void *arg, bool ok);
+
+/*!
+ * @brief Where a non-blocking read started with beginRead() is at
+ */
+typedef enum _busio_genericdevice_readstate {
+  BUSIO_READ_IDLE = 0, ///< No read going on
+  BUSIO_READ_BUSY,     ///< Still waiting for bytes
+  BUSIO_READ_DONE,     ///< All bytes are in
+  BUSIO_READ_TIMEOUT,  ///< The deadline passed before all bytes came in
+  BUSIO_READ_ERROR,    ///< The read function failed
+} busio_genericdevice_readstate_t;
+
 /*!
  * @brief Class for communicating with a device via generic read/write functions
  */
@@ -36,6 +76,24 @@ public:
   bool writeRegister(uint8_t *addr_buf, uint8_t addrsiz, const uint8_t *buf,
                      uint16_t bufsiz);
 
+  void
+  setBatchFunctions(busio_genericdevice_readv_t readv_func,
+                    busio_genericdevice_writev_t writev_func,
+                    busio_genericdevice_regbatch_t regbatch_func = nullptr);
+  bool readv(const busio_genericdevice_iovec_t *iov, uint8_t iovcnt);
+  bool writev(const busio_genericdevice_iovec_t *iov, uint8_t iovcnt);
+  bool transferRegisters(busio_genericdevice_regop_t *ops, uint8_t count);
+
+  void setAvailableFunction(busio_genericdevice_available_t available_func);
+  bool beginRead(uint8_t *buffer, size_t len, uint32_t timeout_us,
+                 busio_genericdevice_done_t done_func = nullptr,
+                 void *done_arg = nullptr);
+  busio_genericdevice_readstate_t poll(void);
+  void cancelRead(void);
+  bool readTimeout(uint8_t *buffer, size_t len, uint32_t timeout_us);
+
+  void setFrameCRC(const busio_crc_model_t *model);
+
 protected:
   /*! @brief Function pointer for reading raw data from the device */
   busio_genericdevice_read_t _read_func;
@@ -45,12 +103,106 @@ protected:
   busio_genericdevice_readreg_t _readreg_func;
   /*! @brief Function pointer for writing a 'register' to the device */
   busio_genericdevice_writereg_t _writereg_func;
+  /*! @brief Optional function pointer for a scatter read in one go */
+  busio_genericdevice_readv_t _readv_func = nullptr;
+  /*! @brief Optional function pointer for a gather write in one go */
+  busio_genericdevice_writev_t _writev_func = nullptr;
+  /*! @brief Optional function pointer for several registers in one frame */
+  busio_genericdevice_regbatch_t _regbatch_func = nullptr;
+  /*! @brief CRC appended to / checked on every read() and write() frame */
+  const busio_crc_model_t *_frame_crc = nullptr;
 
   bool _begun; ///< whether we have initialized yet (in case the function needs
                ///< to do something)
 
 private:
   void *_obj; ///< Pointer to object instance
+
+  busio_genericdevice_available_t _available_func = nullptr;
+  busio_genericdevice_done_t _done_func = nullptr;
+  void *_done_arg = nullptr;
+  uint8_t *_async_buf = nullptr;
+  size_t _async_len = 0, _async_pos = 0;
+  uint32_t _async_start = 0, _async_timeout = 0;
+  busio_genericdevice_readstate_t _async_state = BUSIO_READ_IDLE;
+
+  busio_genericdevice_readstate_t _finishRead(
+      busio_genericdevice_readstate_t state);
+};
+
+/*!
+ * @brief A GenericDevice that calls straight into a transport class instead
+ * of going through function pointers, so the compiler can inline the calls.
+ * The transport needs read(), write(), readRegister() and writeRegister()
+ * members with the same signatures as here (return false for anything it
+ * can't do). Handing this to Adafruit_BusIO_Register still works, those
+ * calls go through the base class and its function pointers as before.
+ */
+template <class Transport>
+class Adafruit_GenericDeviceT : public Adafruit_GenericDevice {
+public:
+  /*! @brief Create a device on top of a transport object
+      @param transport Pointer to the transport instance */
+  Adafruit_GenericDeviceT(Transport *transport)
+      : Adafruit_GenericDevice(transport, _read, _write, _readreg, _writereg),
+        _transport(transport) {}
+
+  /*! @brief Read data into a buffer
+     @param buffer Pointer to buffer to read data into
+     @param len Number of bytes to read
+     @return true if read was successful, otherwise false */
+  bool read(uint8_t *buffer, size_t len) {
+    if (_frame_crc)
+      return Adafruit_GenericDevice::read(buffer, len);
+    return _begun && _transport->read(buffer, len);
+  }
+  /*! @brief Write a buffer of data
+     @param buffer Pointer to buffer of data to write
+     @param len Number of bytes to write
+     @return true if write was successful, otherwise false */
+  bool write(const uint8_t *buffer, size_t len) {
+    if (_frame_crc)
+      return Adafruit_GenericDevice::write(buffer, len);
+    return _begun && _transport->write(buffer, len);
+  }
+  /*! @brief Read from a register location
+     @param addr_buf Buffer containing register address
+     @param addrsiz Size of register address in bytes
+     @param buf Buffer to store read data
+     @param bufsiz Size of data to read in bytes
+     @return true if read was successful, otherwise false */
+  bool readRegister(uint8_t *addr_buf, uint8_t addrsiz, uint8_t *buf,
+                    uint16_t bufsiz) {
+    return _begun && _transport->readRegister(addr_buf, addrsiz, buf, bufsiz);
+  }
+  /*! @brief Write to a register location
+     @param addr_buf Buffer containing register address
+     @param addrsiz Size of register address in bytes
+     @param buf Buffer containing data to write
+     @param bufsiz Size of data to write in bytes
+     @return true if write was successful, otherwise false */
+  bool writeRegister(uint8_t *addr_buf, uint8_t addrsiz, const uint8_t *buf,
+                     uint16_t bufsiz) {
+    return _begun && _transport->writeRegister(addr_buf, addrsiz, buf, bufsiz);
+  }
+
+private:
+  Transport *_transport;
+
+  static bool _read(void *obj, uint8_t *buffer, size_t len) {
+    return ((Transport *)obj)->read(buffer, len);
+  }
+  static bool _write(void *obj, const uint8_t *buffer, size_t len) {
+    return ((Transport *)obj)->write(buffer, len);
+  }
+  static bool _readreg(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                       uint8_t *data, uint16_t datalen) {
+    return ((Transport *)obj)->readRegister(addr_buf, addrsiz, data, datalen);
+  }
+  static bool _writereg(void *obj, uint8_t *addr_buf, uint8_t addrsiz,
+                        const uint8_t *data, uint16_t datalen) {
+    return ((Transport *)obj)->writeRegister(addr_buf, addrsiz, data, datalen);
+  }
 };
 
 #endif // ADAFRUIT_GENERICDEVICE_H
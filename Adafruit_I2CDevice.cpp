@@ -1,7 +1,29 @@
 #include "Adafruit_I2CDevice.h"
+#include "Adafruit_BusIO_CRC.h"
+#include "Adafruit_BusIO_Capture.h"
+#include "Adafruit_BusIO_Linux.h"
+#include "Adafruit_SoftI2C.h"
 
 // #define DEBUG_SERIAL Serial
 
+// endTransmission() return codes are the same across the Arduino cores
+static Adafruit_BusIO_I2CError busio_wire_error(uint8_t code) {
+  switch (code) {
+  case 0:
+    return BUSIO_I2C_OK;
+  case 1:
+    return BUSIO_I2C_ERR_TOO_LONG;
+  case 2:
+    return BUSIO_I2C_ERR_ADDR_NACK;
+  case 3:
+    return BUSIO_I2C_ERR_DATA_NACK;
+  case 5:
+    return BUSIO_I2C_ERR_TIMEOUT;
+  default:
+    return BUSIO_I2C_ERR_ARB_LOST;
+  }
+}
+
 /*!
  *    @brief  Create an I2C device at a given address
  *    @param  addr The 7-bit I2C address for the device
@@ -20,6 +42,34 @@ Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire) {
 #endif
 }
 
+/*!
+ *    @brief  Create an I2C device at a given address on a software I2C bus
+ *    @param  addr The 7-bit I2C address for the device
+ *    @param  theSoftWire The bit-banged I2C bus to use
+ */
+Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr,
+                                       Adafruit_SoftI2C *theSoftWire) {
+  _addr = addr;
+  _softwire = theSoftWire;
+  _begun = false;
+  _maxBufferSize = (size_t)-1; // no buffer to overflow, bytes go straight out
+}
+
+#ifdef BUSIO_HAS_LINUX
+/*!
+ *    @brief  Create an I2C device at a given address on a Linux i2c-dev bus
+ *    @param  addr The 7-bit I2C address for the device
+ *    @param  theLinuxBus The /dev/i2c-N bus to use
+ */
+Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr,
+                                       Adafruit_LinuxI2C *theLinuxBus) {
+  _addr = addr;
+  _linux = theLinuxBus;
+  _begun = false;
+  _maxBufferSize = BUSIO_LINUX_I2C_BUF;
+}
+#endif
+
 /*!
  *    @brief  Initializes and does basic address detection
  *    @param  addr_detect Whether we should attempt to detect the I2C address
@@ -28,7 +78,16 @@ Adafruit_I2CDevice::Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire) {
  *    @return True if I2C initialized and a device with the addr found
  */
 bool Adafruit_I2CDevice::begin(bool addr_detect) {
-  _wire->begin();
+#ifdef BUSIO_HAS_LINUX
+  if (_linux && !_linux->begin()) {
+    return false;
+  }
+#endif
+  if (_softwire) {
+    _softwire->begin();
+  } else if (_wire) {
+    _wire->begin();
+  }
   _begun = true;
 
   if (addr_detect) {
@@ -41,6 +100,18 @@ bool Adafruit_I2CDevice::begin(bool addr_detect) {
  *    @brief  De-initialize device, turn off the Wire interface
  */
 void Adafruit_I2CDevice::end(void) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    _linux->end();
+    _begun = false;
+    return;
+  }
+#endif
+  if (_softwire) {
+    _softwire->end();
+    _begun = false;
+    return;
+  }
   // Not all port implement Wire::end(), such as
   // - ESP8266
   // - AVR core without WIRE_HAS_END
@@ -54,9 +125,27 @@ void Adafruit_I2CDevice::end(void) {
 #endif
 }
 
+#ifndef BUSIO_I2C_PRESENCE_BUSES
+#define BUSIO_I2C_PRESENCE_BUSES 2 ///< How many buses can keep a presence map
+#endif
+#ifndef BUSIO_I2C_SCAN_TIMEOUT_US
+#define BUSIO_I2C_SCAN_TIMEOUT_US 1000 ///< Per-address timeout while scanning
+#endif
+
+// One bit per 7-bit address for every bus that has been scanned, shared by
+// all the devices on that bus so only the first begin() pays for the probes
+struct busio_i2c_presence_t {
+  const void *bus;     ///< The TwoWire or Adafruit_SoftI2C scanned
+  uint8_t scanned[16]; ///< Bitmap of addresses that were probed
+  uint8_t present[16]; ///< Bitmap of addresses that ACK'd
+};
+
+static busio_i2c_presence_t _presence[BUSIO_I2C_PRESENCE_BUSES];
+
 /*!
  *    @brief  Scans I2C for the address - note will give a false-positive
- *    if there's no pullups on I2C
+ *    if there's no pullups on I2C. If scanBus() covered the address the
+ *    cached result is returned without touching the bus.
  *    @return True if I2C initialized and a device with the addr found
  */
 bool Adafruit_I2CDevice::detected(void) {
@@ -65,16 +154,21 @@ bool Adafruit_I2CDevice::detected(void) {
     return false;
   }
 
-  // A basic scanner, see if it ACK's
-  _wire->beginTransmission(_addr);
 #ifdef DEBUG_SERIAL
   DEBUG_SERIAL.print(F("Address 0x"));
   DEBUG_SERIAL.print(_addr, HEX);
 #endif
-#ifdef ARDUINO_ARCH_MBED
-  _wire->write(0); // forces a write request instead of a read
-#endif
-  if (_wire->endTransmission() == 0) {
+
+  bool found;
+  busio_i2c_presence_t *map = _presenceMap(false);
+  uint8_t bit = 1 << (_addr & 0x7);
+  if (map && (map->scanned[_addr >> 3] & bit)) {
+    found = map->present[_addr >> 3] & bit;
+  } else {
+    found = _probe(_addr);
+  }
+
+  if (found) {
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.println(F(" Detected"));
 #endif
@@ -86,6 +180,134 @@ bool Adafruit_I2CDevice::detected(void) {
   return false;
 }
 
+/*!
+ *    @brief  Probe every address in a range with a short timeout and remember
+ *    which ones ACK'd, so that detected() and begin() of every device on this
+ *    bus can skip their own probe. Addresses outside the range keep what an
+ *    earlier scan found, or get probed by detected() as before
+ *    @param  first The first 7-bit address to probe, defaults to 0x08
+ *    @param  last The last 7-bit address to probe, defaults to 0x77
+ *    @return The number of devices found
+ */
+uint8_t Adafruit_I2CDevice::scanBus(uint8_t first, uint8_t last) {
+  if (!_begun) {
+    begin(false);
+  }
+
+#if defined(WIRE_HAS_TIMEOUT)
+  if (_wire) {
+    _wire->setWireTimeout(BUSIO_I2C_SCAN_TIMEOUT_US, true);
+  }
+#elif defined(ARDUINO_ARCH_ESP32)
+  uint16_t timeout_ms = 0;
+  if (_wire) {
+    timeout_ms = _wire->getTimeOut();
+    _wire->setTimeOut((BUSIO_I2C_SCAN_TIMEOUT_US + 999) / 1000);
+  }
+#endif
+
+  busio_i2c_presence_t *map = _presenceMap(true);
+  uint8_t found = 0;
+  for (uint8_t addr = first; (addr <= last) && (addr < 0x80); addr++) {
+    bool ack = _probe(addr);
+    if (ack) {
+      found++;
+    }
+    if (map) {
+      uint8_t bit = 1 << (addr & 0x7);
+      map->scanned[addr >> 3] |= bit;
+      if (ack) {
+        map->present[addr >> 3] |= bit;
+      } else {
+        map->present[addr >> 3] &= ~bit;
+      }
+    }
+  }
+
+#if defined(WIRE_HAS_TIMEOUT)
+  if (_wire && !_timeout_us) {
+    _wire->setWireTimeout(); // back to the core defaults
+  }
+#elif defined(ARDUINO_ARCH_ESP32)
+  if (_wire) {
+    _wire->setTimeOut(timeout_ms);
+  }
+#endif
+  _applyTimeout(); // or to the one setTimeout() asked for
+
+  return found;
+}
+
+/*!
+ *    @brief  Forget the presence map of this device's bus, e.g. after
+ *    hot-plugging something. detected() goes back to probing the bus.
+ */
+void Adafruit_I2CDevice::invalidatePresence(void) {
+  busio_i2c_presence_t *map = _presenceMap(false);
+  if (map) {
+    map->bus = nullptr;
+  }
+}
+
+/*!
+ *    @brief  Find the presence map for the bus this device lives on
+ *    @param  create Whether to claim a free slot if the bus has none
+ *    @return Pointer to the map, or nullptr if there is none (or no room)
+ */
+busio_i2c_presence_t *Adafruit_I2CDevice::_presenceMap(bool create) {
+  const void *bus = _softwire ? (const void *)_softwire : (const void *)_wire;
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    bus = _linux;
+  }
+#endif
+  busio_i2c_presence_t *empty = nullptr;
+
+  for (uint8_t i = 0; i < BUSIO_I2C_PRESENCE_BUSES; i++) {
+    if (_presence[i].bus == bus) {
+      return &_presence[i];
+    }
+    if (!empty && !_presence[i].bus) {
+      empty = &_presence[i];
+    }
+  }
+  if (create && empty) {
+    empty->bus = bus;
+    memset(empty->scanned, 0, sizeof(empty->scanned));
+    memset(empty->present, 0, sizeof(empty->present));
+    return empty;
+  }
+  return nullptr;
+}
+
+/*!
+ *    @brief  See if an address ACKs, always going out on the bus
+ *    @param  addr The 7-bit address to probe
+ *    @return True if a device ACK'd the address
+ */
+bool Adafruit_I2CDevice::_probe(uint8_t addr) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    bool found = _linux->probe(addr);
+    _error = _linux->lastError();
+    return found;
+  }
+#endif
+  if (_softwire) {
+    bool found = _softwire->probe(addr);
+    _error = _softwire->lastError();
+    return found;
+  }
+
+  // A basic scanner, see if it ACK's
+  _wire->beginTransmission(addr);
+#ifdef ARDUINO_ARCH_MBED
+  _wire->write(0); // forces a write request instead of a read
+#endif
+  _error = busio_wire_error(_wire->endTransmission());
+  return (_error == BUSIO_I2C_OK);
+}
+
 /*!
  *    @brief  Write a buffer or two to the I2C device. Cannot be more than
  * maxBufferSize() bytes.
@@ -102,16 +324,51 @@ bool Adafruit_I2CDevice::detected(void) {
 bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
                                const uint8_t *prefix_buffer,
                                size_t prefix_len) {
-  if ((len + prefix_len) > maxBufferSize()) {
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_I2C, BUSIO_CAPTURE_WRITE, _addr,
+                      prefix_buffer, prefix_len, buffer, len, nullptr, 0);
+  for (uint8_t attempt = 0;; attempt++) {
+    if (_write(buffer, len, stop, prefix_buffer, prefix_len)) {
+      return _track(true);
+    }
+    if (!_retry(attempt)) {
+      return _track(false);
+    }
+  }
+}
+
+bool Adafruit_I2CDevice::_write(const uint8_t *buffer, size_t len, bool stop,
+                                const uint8_t *prefix_buffer,
+                                size_t prefix_len) {
+  size_t pec_len = (_pec && stop) ? 1 : 0;
+  if ((len + prefix_len) > (maxBufferSize() - pec_len)) {
     // currently not guaranteed to work if more than 32 bytes!
     // we will need to find out if some platforms have larger
     // I2C buffer sizes :/
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.println(F("\tI2CDevice could not write such a large buffer"));
 #endif
+    _error = BUSIO_I2C_ERR_TOO_LONG;
+    _pec_open = false;
     return false;
   }
 
+  _applyTimeout();
+
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    bool ok = _linux->write(_addr, buffer, len, stop, prefix_buffer,
+                            prefix_len);
+    _error = _linux->lastError();
+    return ok;
+  }
+#endif
+  if (_softwire) {
+    bool ok = _softwire->write(_addr, buffer, len, stop, prefix_buffer,
+                               prefix_len);
+    _error = _softwire->lastError();
+    return ok;
+  }
+
   _wire->beginTransmission(_addr);
 
   // Write the prefix data (usually an address)
@@ -120,6 +377,7 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
 #ifdef DEBUG_SERIAL
       DEBUG_SERIAL.println(F("\tI2CDevice failed to write"));
 #endif
+      _error = BUSIO_I2C_ERR_TOO_LONG;
       return false;
     }
   }
@@ -129,9 +387,27 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.println(F("\tI2CDevice failed to write"));
 #endif
+    _error = BUSIO_I2C_ERR_TOO_LONG;
     return false;
   }
 
+  if (_pec) {
+    // the PEC covers everything since the START, a repeated start included
+    uint8_t addr_byte = _addr << 1;
+    if (!_pec_open) {
+      _pec_crc = 0;
+    }
+    _pec_crc = Adafruit_BusIO_CRC::smbus(_pec_crc, &addr_byte, 1);
+    if (prefix_buffer != nullptr) {
+      _pec_crc = Adafruit_BusIO_CRC::smbus(_pec_crc, prefix_buffer, prefix_len);
+    }
+    _pec_crc = Adafruit_BusIO_CRC::smbus(_pec_crc, buffer, len);
+    if (stop && (_wire->write(_pec_crc) != 1)) {
+      _error = BUSIO_I2C_ERR_TOO_LONG;
+      return false;
+    }
+  }
+
 #ifdef DEBUG_SERIAL
 
   DEBUG_SERIAL.print(F("\tI2CWRITE @ 0x"));
@@ -158,7 +434,9 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
   }
 #endif
 
-  if (_wire->endTransmission(stop) == 0) {
+  _error = busio_wire_error(_wire->endTransmission(stop));
+  _pec_open = _pec && !stop && (_error == BUSIO_I2C_OK);
+  if (_error == BUSIO_I2C_OK) {
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.println();
     // DEBUG_SERIAL.println("Sent!");
@@ -181,6 +459,29 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
  *    @return True if read was successful, otherwise false.
  */
 bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop) {
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_I2C, BUSIO_CAPTURE_READ, _addr, nullptr, 0,
+                      nullptr, 0, buffer, len);
+  for (uint8_t attempt = 0;; attempt++) {
+    if (_readChunked(buffer, len, stop)) {
+      return _track(true);
+    }
+    if (!_retry(attempt)) {
+      return _track(false);
+    }
+  }
+}
+
+bool Adafruit_I2CDevice::_readChunked(uint8_t *buffer, size_t len, bool stop) {
+  _applyTimeout();
+  _error = BUSIO_I2C_OK;
+
+  if (_pec && !_softwire && (len > (maxBufferSize() - 1))) {
+    // the PEC byte comes at the very end, so the read can't be split up
+    _error = BUSIO_I2C_ERR_TOO_LONG;
+    _pec_open = false;
+    return false;
+  }
+
   size_t pos = 0;
   while (pos < len) {
     size_t read_len =
@@ -194,19 +495,44 @@ bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop) {
 }
 
 bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    bool ok = _linux->read(_addr, buffer, len, stop);
+    _error = _linux->lastError();
+    return ok;
+  }
+#endif
+  if (_softwire) {
+    bool ok = _softwire->read(_addr, buffer, len, stop);
+    _error = _softwire->lastError();
+    return ok;
+  }
+
+  bool pec_open = _pec_open;
+  size_t pec_len = _pec ? 1 : 0;
+  _pec_open = false;
+
 #if defined(TinyWireM_h)
-  size_t recv = _wire->requestFrom((uint8_t)_addr, (uint8_t)len);
+  size_t recv = _wire->requestFrom((uint8_t)_addr, (uint8_t)(len + pec_len));
 #elif defined(ARDUINO_ARCH_MEGAAVR)
-  size_t recv = _wire->requestFrom(_addr, len, stop);
+  size_t recv = _wire->requestFrom(_addr, len + pec_len, stop);
 #else
-  size_t recv = _wire->requestFrom((uint8_t)_addr, (uint8_t)len, (uint8_t)stop);
+  size_t recv = _wire->requestFrom((uint8_t)_addr, (uint8_t)(len + pec_len),
+                                   (uint8_t)stop);
 #endif
 
-  if (recv != len) {
+  if (recv != (len + pec_len)) {
     // Not enough data available to fulfill our obligation!
 #ifdef DEBUG_SERIAL
     DEBUG_SERIAL.print(F("\tI2CDevice did not receive enough data: "));
     DEBUG_SERIAL.println(recv);
+#endif
+    _error = BUSIO_I2C_ERR_SHORT_READ;
+#if defined(WIRE_HAS_TIMEOUT)
+    if (_wire->getWireTimeoutFlag()) {
+      _wire->clearWireTimeoutFlag();
+      _error = BUSIO_I2C_ERR_TIMEOUT;
+    }
 #endif
     return false;
   }
@@ -214,6 +540,21 @@ bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
   for (uint16_t i = 0; i < len; i++) {
     buffer[i] = _wire->read();
   }
+  _error = BUSIO_I2C_OK;
+
+  if (_pec) {
+    uint8_t addr_byte = (_addr << 1) | 1;
+    uint8_t crc = pec_open ? _pec_crc : 0;
+    crc = Adafruit_BusIO_CRC::smbus(crc, &addr_byte, 1);
+    crc = Adafruit_BusIO_CRC::smbus(crc, buffer, len);
+    if ((uint8_t)_wire->read() != crc) {
+#ifdef DEBUG_SERIAL
+      DEBUG_SERIAL.println(F("\tI2CDevice PEC mismatch"));
+#endif
+      _error = BUSIO_I2C_ERR_PEC;
+      return false;
+    }
+  }
 
 #ifdef DEBUG_SERIAL
   DEBUG_SERIAL.print(F("\tI2CREAD  @ 0x"));
@@ -247,11 +588,139 @@ bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
 bool Adafruit_I2CDevice::write_then_read(const uint8_t *write_buffer,
                                          size_t write_len, uint8_t *read_buffer,
                                          size_t read_len, bool stop) {
-  if (!write(write_buffer, write_len, stop)) {
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_I2C, BUSIO_CAPTURE_WRITE_THEN_READ, _addr,
+                      nullptr, 0, write_buffer, write_len, read_buffer,
+                      read_len);
+  for (uint8_t attempt = 0;; attempt++) {
+    if (_write(write_buffer, write_len, stop, nullptr, 0) &&
+        _readChunked(read_buffer, read_len, true)) {
+      return _track(true);
+    }
+    if (!_retry(attempt)) {
+      return _track(false);
+    }
+  }
+}
+
+/*!
+ *    @brief  Wait for the device to ACK its address again, which is how
+ *    EEPROMs (and the like) say their internal write cycle has finished.
+ *    Returns as soon as that happens instead of sitting out the worst case.
+ *    @param  timeout_us How long to keep polling, in microseconds
+ *    @param  interval_us How long to wait between polls, 0 to poll
+ *    back-to-back
+ *    @return True if the device ACK'd before the timeout
+ */
+bool Adafruit_I2CDevice::waitForAck(uint32_t timeout_us, uint16_t interval_us) {
+  uint32_t start = micros();
+
+  while (!_probe(_addr)) {
+    if ((micros() - start) >= timeout_us) {
+      _error = BUSIO_I2C_ERR_TIMEOUT;
+      return false;
+    }
+    if (interval_us) {
+      delayMicroseconds(interval_us);
+    }
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Write a block of any length to a memory-style device (EEPROM,
+ *    FRAM) with the memory address sent MSB first before the data. The block
+ *    is split on page boundaries and maxBufferSize(), and after each page we
+ *    ACK-poll for the write cycle to end before going on.
+ *    @param  mem_addr The memory address of the first byte
+ *    @param  addr_width Number of memory address bytes, 1 to 4
+ *    @param  buffer Pointer to buffer of data to write
+ *    @param  len Number of bytes from buffer to write
+ *    @param  page_size The device's write page size in bytes, writes never
+ *    cross a page boundary
+ *    @param  timeout_us The longest write cycle to wait for, per page. 0 skips
+ *    the ACK polling for devices without a write cycle
+ *    @return True if every page was written and acknowledged
+ */
+bool Adafruit_I2CDevice::writePaged(uint32_t mem_addr, uint8_t addr_width,
+                                    const uint8_t *buffer, size_t len,
+                                    uint16_t page_size, uint32_t timeout_us) {
+  uint8_t prefix[4];
+  size_t room = maxBufferSize() - (_pec ? 1 : 0); // the PEC byte goes too
+
+  if ((addr_width == 0) || (addr_width > 4) || (page_size == 0) ||
+      (room <= addr_width)) {
+    return false;
+  }
+
+  while (len) {
+    size_t chunk = page_size - (mem_addr % page_size);
+    if (chunk > (room - addr_width)) {
+      chunk = room - addr_width;
+    }
+    if (chunk > len) {
+      chunk = len;
+    }
+
+    for (uint8_t i = 0; i < addr_width; i++) {
+      prefix[i] = mem_addr >> (8 * (addr_width - i - 1));
+    }
+    if (!write(buffer, chunk, true, prefix, addr_width)) {
+      return false;
+    }
+    if (timeout_us && !waitForAck(timeout_us)) {
+      return false;
+    }
+
+    buffer += chunk;
+    mem_addr += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Write a byte or word pattern over and over, e.g. to clear a
+ *    display, without a buffer the size of the whole fill. It goes out in
+ *    as few transactions as the bus buffer allows, each one starting with
+ *    the prefix.
+ *    @param  pattern The bytes to repeat
+ *    @param  pattern_len Number of bytes in the pattern, at most
+ *    BUSIO_REPEAT_BURST and small enough to fit in a transaction with the
+ *    prefix
+ *    @param  count How many times to write the pattern
+ *    @param  prefix_buffer Pointer to optional array of data to write at the
+ *    start of every transaction, e.g. a control byte
+ *    @param  prefix_len Number of bytes from prefix buffer to write
+ *    @return True if every transaction was successful, otherwise false.
+ */
+bool Adafruit_I2CDevice::writeRepeated(const uint8_t *pattern,
+                                       size_t pattern_len, size_t count,
+                                       const uint8_t *prefix_buffer,
+                                       size_t prefix_len) {
+  uint8_t burst[BUSIO_REPEAT_BURST];
+  size_t room = maxBufferSize() - (_pec ? 1 : 0);
+  room = (room > prefix_len) ? (room - prefix_len) : 0;
+  if (room > sizeof(burst)) {
+    room = sizeof(burst);
+  }
+  if ((pattern_len == 0) || (pattern_len > room)) {
     return false;
   }
 
-  return read(read_buffer, read_len);
+  size_t per_burst = room / pattern_len; // whole patterns per transaction
+  size_t fill = (per_burst < count) ? per_burst : count;
+  for (size_t i = 0; i < fill; i++) {
+    memcpy(burst + i * pattern_len, pattern, pattern_len);
+  }
+
+  while (count) {
+    size_t n = (count < per_burst) ? count : per_burst;
+    if (!write(burst, n * pattern_len, true, prefix_buffer, prefix_len)) {
+      return false;
+    }
+    count -= n;
+  }
+  return true;
 }
 
 /*!
@@ -268,6 +737,17 @@ uint8_t Adafruit_I2CDevice::address(void) { return _addr; }
  *    Not necessarily that the speed was achieved!
  */
 bool Adafruit_I2CDevice::setSpeed(uint32_t desiredclk) {
+  _freq = desiredclk;
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    return false; // the kernel sets the bus clock, from the device tree
+  }
+#endif
+  if (_softwire) {
+    _softwire->setClock(desiredclk);
+    return true;
+  }
+
 #if defined(__AVR_ATmega328__) ||                                              \
     defined(__AVR_ATmega328P__) // fix arduino core set clock
   // calculate TWBR correctly
@@ -318,3 +798,212 @@ bool Adafruit_I2CDevice::setSpeed(uint32_t desiredclk) {
   return false;
 #endif
 }
+
+/*!
+ *    @brief  Find the fastest clock this device works at over the wiring it
+ *    is on, by stepping the clock up 25% at a time while reading back a
+ *    register with a known value, then taking a safety margin off the fastest
+ *    clock that passed. The device is left running at the result. Retries
+ *    are off while calibrating, so a flaky clock can't pass by retrying.
+ *    @param  reg A register on this device with a known value, e.g. its ID
+ *    @param  expected The value reg must read back as
+ *    @param  min_freq The clock to start at, in Hz
+ *    @param  max_freq The clock not to go past, in Hz
+ *    @param  margin_pct How many percent to take off the fastest passing clock
+ *    @param  reads How many reads in a row must match at each step
+ *    @return The clock now in use in Hz, or 0 if even min_freq failed (the
+ *    previous clock is restored then)
+ */
+uint32_t Adafruit_I2CDevice::calibrateSpeed(Adafruit_BusIO_Register *reg,
+                                            uint32_t expected,
+                                            uint32_t min_freq,
+                                            uint32_t max_freq,
+                                            uint8_t margin_pct, uint8_t reads) {
+  uint32_t previous = _freq, best = 0;
+  uint8_t retries = _retries;
+  _retries = 0;
+
+  for (uint32_t freq = min_freq; freq && (freq <= max_freq);
+       freq = _tuner.step(freq)) {
+    if (!setSpeed(freq) || !_tuner.verify(reg, expected, reads)) {
+      break;
+    }
+    best = freq;
+  }
+
+  _retries = retries;
+  best = _tuner.settle(min_freq, best, margin_pct);
+  setSpeed(best ? best : previous);
+  return best;
+}
+
+/*!
+ *    @brief  Step the clock down 25% (but not under the calibration minimum,
+ *    or 100KHz before any calibration) whenever too many transactions in a
+ *    row fail
+ *    @param  max_errors How many failed transactions within the window
+ *    trigger a step down, 0 to turn this off
+ *    @param  window How many transactions make up the window
+ */
+void Adafruit_I2CDevice::setSpeedBackoff(uint8_t max_errors, uint8_t window) {
+  _tuner.setBackoff(max_errors, window);
+}
+
+/*!
+ *    @brief  Turn SMBus Packet Error Checking on or off for this device. When
+ *    on, a PEC byte is appended to every write that ends with a STOP, and one
+ *    is read and checked after every read. Mismatches fail the transaction
+ *    with BUSIO_I2C_ERR_PEC (and are retried like any other error). The
+ *    device has to support PEC, and has to have it turned on
+ *    @param  enable True to send and check PEC bytes
+ */
+void Adafruit_I2CDevice::setPEC(bool enable) {
+  _pec = enable;
+  _pec_open = false;
+  if (_softwire) {
+    _softwire->setPEC(enable);
+  }
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    _linux->setPEC(enable);
+  }
+#endif
+}
+
+/*!
+ *    @brief  Bound how long a single transaction may take, so a stuck bus or a
+ *    device stretching the clock forever can't hang the caller. Relies on
+ *    the core's Wire timeout support (AVR/megaAVR, ESP32), the software bus
+ *    or i2c-dev on Linux (which counts in 10ms steps).
+ *    @param  timeout_us The timeout in microseconds, 0 to go back to the
+ *    default: the core's for Wire, 25ms on the software bus, 1s on i2c-dev
+ */
+void Adafruit_I2CDevice::setTimeout(uint32_t timeout_us) {
+  _timeout_reset = _timeout_reset || (_timeout_us && !timeout_us);
+  _timeout_us = timeout_us;
+}
+
+/*!
+ *    @brief  Retry failed transactions, waiting a little longer each time.
+ *    Data that doesn't fit in the buffer is never retried.
+ *    @param  retries How many times to retry, 0 to give up right away
+ *    @param  backoff_us How long to wait before the first retry, doubling
+ *    with every attempt after that
+ *    @param  recover Whether to run recoverBus() before retrying after a
+ *    timeout or bus error
+ */
+void Adafruit_I2CDevice::setRetries(uint8_t retries, uint16_t backoff_us,
+                                    bool recover) {
+  _retries = retries;
+  _backoff_us = backoff_us;
+  _recover = recover;
+}
+
+/*!
+ *    @brief  Tell us which pins the hardware I2C bus is on, so recoverBus()
+ *    can clock out a device that is holding SDA low. Not needed for software
+ *    I2C, which knows its pins already.
+ *    @param  sdapin The arduino pin number of SDA
+ *    @param  sclpin The arduino pin number of SCL
+ */
+void Adafruit_I2CDevice::setRecoveryPins(int8_t sdapin, int8_t sclpin) {
+  _sda = sdapin;
+  _scl = sclpin;
+}
+
+/*!
+ *    @brief  Try to get a stuck bus going again: clock SCL up to 9 times until
+ *    the device holding SDA lets go, send a STOP and restart the Wire
+ *    interface. Without recovery pins only the Wire restart is done.
+ *    @return True if the bus looks idle afterwards
+ */
+bool Adafruit_I2CDevice::recoverBus(void) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    // the adapter driver does its own recovery, all we can do is reopen
+    _linux->end();
+    return _linux->begin();
+  }
+#endif
+  if (_softwire) {
+    return _softwire->recoverBus();
+  }
+
+  bool ok = true;
+  end();
+  if ((_sda != -1) && (_scl != -1)) {
+    // borrow the pins for a moment, Wire.begin() takes them back
+    Adafruit_SoftI2C bitbang(_sda, _scl);
+    ok = bitbang.recoverBus();
+  }
+  _wire->begin();
+  _begun = true;
+  return ok;
+}
+
+/*!
+ *    @brief  Decide whether to go around again after a failed transaction,
+ *    waiting out the backoff (and recovering the bus) if so
+ *    @param  attempt How many retries were already done
+ *    @return True if the transaction should be tried again
+ */
+bool Adafruit_I2CDevice::_retry(uint8_t attempt) {
+  if ((attempt >= _retries) || (_error == BUSIO_I2C_ERR_TOO_LONG)) {
+    return false;
+  }
+  if (_recover && ((_error == BUSIO_I2C_ERR_TIMEOUT) ||
+                   (_error == BUSIO_I2C_ERR_ARB_LOST))) {
+    recoverBus();
+  }
+  uint32_t wait = (uint32_t)_backoff_us << (attempt < 16 ? attempt : 16);
+  if (wait > 16383) {
+    delay(wait / 1000); // delayMicroseconds() is only good to ~16ms
+  } else if (wait) {
+    delayMicroseconds(wait);
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Count a finished transaction towards the error rate, slowing the
+ *    clock down if setSpeedBackoff() says so
+ *    @param  ok Whether the transaction went through
+ *    @return ok, so this can wrap the return value
+ */
+bool Adafruit_I2CDevice::_track(bool ok) {
+  uint32_t freq = _tuner.record(ok, _freq);
+  if (freq) {
+    setSpeed(freq);
+  }
+  return BUSIO_CAPTURE_END(ok);
+}
+
+/*!
+ *    @brief  Push this device's transaction timeout down to the bus, which may
+ *    be shared with devices that use a different one
+ */
+void Adafruit_I2CDevice::_applyTimeout(void) {
+  if (!_timeout_us && !_timeout_reset) {
+    return; // never set, leave the bus alone
+  }
+  _timeout_reset = false;
+  if (_softwire) {
+    _softwire->setClockStretchTimeout(_timeout_us);
+    return;
+  }
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    _linux->setClockStretchTimeout(_timeout_us);
+    return;
+  }
+#endif
+#if defined(WIRE_HAS_TIMEOUT)
+  if (_timeout_us) {
+    _wire->setWireTimeout(_timeout_us, true);
+  } else {
+    _wire->setWireTimeout();
+  }
+#elif defined(ARDUINO_ARCH_ESP32)
+  _wire->setTimeOut(_timeout_us ? (_timeout_us + 999) / 1000 : 50);
+#endif
+}
@@ -1,17 +1,54 @@
 #ifndef Adafruit_I2CDevice_h
 #define Adafruit_I2CDevice_h
 
+#include <Adafruit_BusIO_SpeedTuner.h>
 #include <Arduino.h>
 #include <Wire.h>
 
+class Adafruit_SoftI2C;
+class Adafruit_LinuxI2C;
+struct busio_i2c_presence_t;
+
+/*!
+ * @brief Why an I2C transaction failed, so transient errors (worth a retry)
+ * can be told apart from permanent ones
+ */
+typedef enum _Adafruit_BusIO_I2CError {
+  BUSIO_I2C_OK = 0,         ///< No error
+  BUSIO_I2C_ERR_TOO_LONG,   ///< Data did not fit in the transmit buffer
+  BUSIO_I2C_ERR_ADDR_NACK,  ///< Address was not ACK'd (no device, or busy)
+  BUSIO_I2C_ERR_DATA_NACK,  ///< A data byte was not ACK'd
+  BUSIO_I2C_ERR_ARB_LOST,   ///< Lost arbitration or other bus error
+  BUSIO_I2C_ERR_SHORT_READ, ///< Fewer bytes were received than requested
+  BUSIO_I2C_ERR_TIMEOUT,    ///< The bus or device was stuck past the timeout
+  BUSIO_I2C_ERR_PEC,        ///< The SMBus PEC byte did not match the data
+} Adafruit_BusIO_I2CError;
+
+///< Stack buffer writeRepeated() builds its bursts in, bigger is faster
+#ifndef BUSIO_REPEAT_BURST
+#define BUSIO_REPEAT_BURST 32
+#endif
+
+// Linux boards get i2c-dev and spidev buses, see Adafruit_BusIO_Linux.h.
+// Define BUSIO_NO_LINUX to leave them out
+#if !defined(BUSIO_HAS_LINUX) && defined(__linux__) && !defined(BUSIO_NO_LINUX)
+#define BUSIO_HAS_LINUX
+#endif
+
 ///< The class which defines how we will talk to this device over I2C
 class Adafruit_I2CDevice {
 public:
   Adafruit_I2CDevice(uint8_t addr, TwoWire *theWire = &Wire);
+  Adafruit_I2CDevice(uint8_t addr, Adafruit_SoftI2C *theSoftWire);
+#ifdef BUSIO_HAS_LINUX
+  Adafruit_I2CDevice(uint8_t addr, Adafruit_LinuxI2C *theLinuxBus);
+#endif
   uint8_t address(void);
   bool begin(bool addr_detect = true);
   void end(void);
   bool detected(void);
+  uint8_t scanBus(uint8_t first = 0x08, uint8_t last = 0x77);
+  void invalidatePresence(void);
 
   bool read(uint8_t *buffer, size_t len, bool stop = true);
   bool write(const uint8_t *buffer, size_t len, bool stop = true,
@@ -21,16 +58,72 @@ public:
                        bool stop = false);
   bool setSpeed(uint32_t desiredclk);
 
+  uint32_t calibrateSpeed(Adafruit_BusIO_Register *reg, uint32_t expected,
+                          uint32_t min_freq = 100000,
+                          uint32_t max_freq = 1000000, uint8_t margin_pct = 20,
+                          uint8_t reads = 8);
+  void setSpeedBackoff(uint8_t max_errors, uint8_t window = 32);
+  /*!   @brief  The speed picked by calibrateSpeed(), e.g. to store it away and
+   *    hand it to setSpeed() on the next boot
+   *    @return The calibrated clock in Hz, 0 if never calibrated */
+  uint32_t calibratedSpeed(void) { return _tuner.calibrated(); }
+
+  bool waitForAck(uint32_t timeout_us = 10000, uint16_t interval_us = 0);
+  bool writePaged(uint32_t mem_addr, uint8_t addr_width,
+                  const uint8_t *buffer, size_t len, uint16_t page_size,
+                  uint32_t timeout_us = 10000);
+  bool writeRepeated(const uint8_t *pattern, size_t pattern_len, size_t count,
+                     const uint8_t *prefix_buffer = nullptr,
+                     size_t prefix_len = 0);
+
+  void setPEC(bool enable);
+
+  void setTimeout(uint32_t timeout_us);
+  void setRetries(uint8_t retries, uint16_t backoff_us = 100,
+                  bool recover = false);
+  void setRecoveryPins(int8_t sdapin, int8_t sclpin);
+  bool recoverBus(void);
+
+  /*!   @brief  Why the last transaction failed
+   *    @return The error from the last transaction, BUSIO_I2C_OK on success */
+  Adafruit_BusIO_I2CError lastError(void) { return _error; }
+
   /*!   @brief  How many bytes we can read in a transaction
    *    @return The size of the Wire receive/transmit buffer */
   size_t maxBufferSize() { return _maxBufferSize; }
 
 private:
+  friend class Adafruit_BusIO_DeviceGroup; // sends General Calls on our bus
+
   uint8_t _addr;
-  TwoWire *_wire;
+  TwoWire *_wire = nullptr;
+  Adafruit_SoftI2C *_softwire = nullptr;
+#ifdef BUSIO_HAS_LINUX
+  Adafruit_LinuxI2C *_linux = nullptr;
+#endif
   bool _begun;
   size_t _maxBufferSize;
+  Adafruit_BusIO_I2CError _error = BUSIO_I2C_OK;
+  uint32_t _timeout_us = 0;
+  bool _timeout_reset = false; // setTimeout(0) after a timeout was set
+  uint16_t _backoff_us = 0;
+  uint8_t _retries = 0;
+  bool _recover = false;
+  int8_t _sda = -1, _scl = -1;
+  uint32_t _freq = 100000;
+  Adafruit_BusIO_SpeedTuner _tuner{100000}; // backs off to Standard-mode
+  bool _pec = false;
+  bool _pec_open = false; // last write ended without a STOP, keep the PEC
+  uint8_t _pec_crc = 0;
+  bool _write(const uint8_t *buffer, size_t len, bool stop,
+              const uint8_t *prefix_buffer, size_t prefix_len);
+  bool _readChunked(uint8_t *buffer, size_t len, bool stop);
   bool _read(uint8_t *buffer, size_t len, bool stop);
+  bool _retry(uint8_t attempt);
+  bool _track(bool ok);
+  void _applyTimeout(void);
+  bool _probe(uint8_t addr);
+  busio_i2c_presence_t *_presenceMap(bool create);
 };
 
 #endif // Adafruit_I2CDevice_h
@@ -1,8 +1,21 @@
 #include "Adafruit_SPIDevice.h"
+#include "Adafruit_BusIO_Capture.h"
+#include "Adafruit_BusIO_Linux.h"
+#include "Adafruit_BusIO_PinSim.h"
 
 // #define DEBUG_SERIAL Serial
 
-#ifdef BUSIO_USE_FAST_PINIO
+static_assert(sizeof(Adafruit_SPIDevice) <= BUSIO_SPIDEVICE_MAX_SIZE,
+              "Adafruit_SPIDevice got bigger, check BUSIO_SPIDEVICE_MAX_SIZE");
+
+#if defined(BUSIO_SIM_PINS)
+#define BUSIO_SET_CLOCK_LOW() Adafruit_BusIO_PinSim::write(_sck, LOW)
+#define BUSIO_SET_CLOCK_HIGH() Adafruit_BusIO_PinSim::write(_sck, HIGH)
+#define BUSIO_READ_MISO() Adafruit_BusIO_PinSim::read(_miso)
+#define BUSIO_WRITE_MOSI(value) Adafruit_BusIO_PinSim::write(_mosi, value)
+#define BUSIO_BIT_DELAY(us) Adafruit_BusIO_PinSim::delay(us)
+#define BUSIO_WRITE_CS(value) Adafruit_BusIO_PinSim::write(_cs, value)
+#elif defined(BUSIO_USE_FAST_PINIO)
 #define BUSIO_SET_CLOCK_LOW() (*clkPort = *clkPort & ~clkPinMask)
 #define BUSIO_SET_CLOCK_HIGH() (*clkPort = *clkPort | clkPinMask)
 #define BUSIO_READ_MISO() (*misoPort & misoPinMask)
@@ -20,6 +33,21 @@
 #define BUSIO_WRITE_MOSI(value) digitalWrite(_mosi, value)
 #endif
 
+#ifndef BUSIO_BIT_DELAY
+#define BUSIO_BIT_DELAY(us) delayMicroseconds(us)
+#define BUSIO_WRITE_CS(value) digitalWrite(_cs, value)
+#endif
+
+#ifdef BUSIO_SPI_NO_LSBFIRST
+// the hardware only shifts MSB first, so LSB first devices get the bits of
+// every byte reversed on the way out and back in
+#define BUSIO_HW_BITORDER(order) SPI_BITORDER_MSBFIRST
+#define BUSIO_HW_REVERSE() (_dataOrder == SPI_BITORDER_LSBFIRST)
+#else
+#define BUSIO_HW_BITORDER(order) (order)
+#define BUSIO_HW_REVERSE() false
+#endif
+
 /*!
  *    @brief  Create an SPI device with the given CS pin and settings
  *    @param  cspin The arduino pin number to use for chip select
@@ -37,7 +65,7 @@ Adafruit_SPIDevice::Adafruit_SPIDevice(int8_t cspin, uint32_t freq,
   _sck = _mosi = _miso = -1;
   _spi = theSPI;
   _begun = false;
-  _spiSetting = new SPISettings(freq, dataOrder, dataMode);
+  _spiSetting = SPISettings(freq, BUSIO_HW_BITORDER(dataOrder), dataMode);
   _freq = freq;
   _dataOrder = dataOrder;
   _dataMode = dataMode;
@@ -94,13 +122,27 @@ Adafruit_SPIDevice::Adafruit_SPIDevice(int8_t cspin, int8_t sckpin,
   _begun = false;
 }
 
+#ifdef BUSIO_HAS_LINUX
 /*!
- *    @brief  Release memory allocated in constructors
+ *    @brief  Create an SPI device on a Linux spidev node, which has its own
+ * CS line driven by the kernel
+ *    @param  spidev The /dev/spidevB.C bus to use
+ *    @param  freq The SPI clock frequency to use, defaults to 1MHz
+ *    @param  dataOrder The SPI data order to use for bits within each byte,
+ * defaults to SPI_BITORDER_MSBFIRST
+ *    @param  dataMode The SPI mode to use, defaults to SPI_MODE0
  */
-Adafruit_SPIDevice::~Adafruit_SPIDevice() {
-  if (_spiSetting)
-    delete _spiSetting;
+Adafruit_SPIDevice::Adafruit_SPIDevice(Adafruit_LinuxSPI *spidev,
+                                       uint32_t freq, BusIOBitOrder dataOrder,
+                                       uint8_t dataMode) {
+  _cs = _sck = _mosi = _miso = -1;
+  _linux = spidev;
+  _freq = freq;
+  _dataOrder = dataOrder;
+  _dataMode = dataMode;
+  _begun = false;
 }
+#endif
 
 /*!
  *    @brief  Initializes SPI bus and sets CS pin high
@@ -108,9 +150,15 @@ Adafruit_SPIDevice::~Adafruit_SPIDevice() {
  * init
  */
 bool Adafruit_SPIDevice::begin(void) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    _begun = _linux->begin();
+    return _begun;
+  }
+#endif
   if (_cs != -1) {
     pinMode(_cs, OUTPUT);
-    digitalWrite(_cs, HIGH);
+    BUSIO_WRITE_CS(HIGH);
   }
 
   if (_spi) { // hardware SPI
@@ -122,14 +170,14 @@ bool Adafruit_SPIDevice::begin(void) {
 
     if ((_dataMode == SPI_MODE0) || (_dataMode == SPI_MODE1)) {
       // idle low on mode 0 and 1
-      digitalWrite(_sck, LOW);
+      BUSIO_SET_CLOCK_LOW();
     } else {
       // idle high on mode 2 or 3
-      digitalWrite(_sck, HIGH);
+      BUSIO_SET_CLOCK_HIGH();
     }
     if (_mosi != -1) {
       pinMode(_mosi, OUTPUT);
-      digitalWrite(_mosi, HIGH);
+      BUSIO_WRITE_MOSI(HIGH);
     }
     if (_miso != -1) {
       pinMode(_miso, INPUT);
@@ -147,20 +195,35 @@ bool Adafruit_SPIDevice::begin(void) {
  *    @param  len    The number of bytes to transfer
  */
 void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    // the bytes are wanted now, CS stays put until endTransaction()
+    _linux->queue(buffer, buffer, len);
+    _linux->flush(true);
+    return;
+  }
+#endif
+
   //
   // HARDWARE SPI
   //
   if (_spi) {
 #ifdef BUSIO_HAS_HW_SPI
-#if defined(SPARK)
-    _spi->transfer(buffer, buffer, len, nullptr);
-#elif defined(STM32)
-    for (size_t i = 0; i < len; i++) {
-      _spi->transfer(buffer[i]);
+    if (BUSIO_HW_REVERSE()) {
+      reverseBits(buffer, len);
     }
+#if (BUSIO_SPI_CAPS & BUSIO_SPI_CAP_INPLACE)
+    BUSIO_SPI_INPLACE(_spi, buffer, len);
+#elif (BUSIO_SPI_CAPS & BUSIO_SPI_CAP_DUPLEX)
+    BUSIO_SPI_DUPLEX(_spi, buffer, buffer, len);
 #else
-    _spi->transfer(buffer, len);
+    for (size_t i = 0; i < len; i++) {
+      buffer[i] = _spi->transfer(buffer[i]);
+    }
 #endif
+    if (BUSIO_HW_REVERSE()) {
+      reverseBits(buffer, len);
+    }
     return;
 #endif
   }
@@ -193,7 +256,7 @@ void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
          b = (_dataOrder == SPI_BITORDER_LSBFIRST) ? b << 1 : b >> 1) {
 
       if (bitdelay_us) {
-        delayMicroseconds(bitdelay_us);
+        BUSIO_BIT_DELAY(bitdelay_us);
       }
 
       if (_dataMode == SPI_MODE0 || _dataMode == SPI_MODE2) {
@@ -206,7 +269,7 @@ void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
         BUSIO_SET_CLOCK_HIGH();
 
         if (bitdelay_us) {
-          delayMicroseconds(bitdelay_us);
+          BUSIO_BIT_DELAY(bitdelay_us);
         }
 
         if (_miso != -1) {
@@ -225,13 +288,13 @@ void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
         BUSIO_SET_CLOCK_LOW();
 
         if (bitdelay_us) {
-          delayMicroseconds(bitdelay_us);
+          BUSIO_BIT_DELAY(bitdelay_us);
         }
 
         BUSIO_SET_CLOCK_HIGH();
 
         if (bitdelay_us) {
-          delayMicroseconds(bitdelay_us);
+          BUSIO_BIT_DELAY(bitdelay_us);
         }
 
         if (_miso != -1) { // read on rising edge
@@ -245,7 +308,7 @@ void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
         BUSIO_SET_CLOCK_HIGH();
 
         if (bitdelay_us) {
-          delayMicroseconds(bitdelay_us);
+          BUSIO_BIT_DELAY(bitdelay_us);
         }
 
         if (_mosi != -1) {
@@ -268,6 +331,70 @@ void Adafruit_SPIDevice::transfer(uint8_t *buffer, size_t len) {
   return;
 }
 
+#if defined(__AVR__)
+static const uint8_t busio_reverse_table[256] PROGMEM = {
+    0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0,
+    0x30, 0xB0, 0x70, 0xF0, 0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8,
+    0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8, 0x04, 0x84, 0x44, 0xC4,
+    0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
+    0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC,
+    0x3C, 0xBC, 0x7C, 0xFC, 0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2,
+    0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2, 0x0A, 0x8A, 0x4A, 0xCA,
+    0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
+    0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6,
+    0x36, 0xB6, 0x76, 0xF6, 0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE,
+    0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE, 0x01, 0x81, 0x41, 0xC1,
+    0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
+    0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9,
+    0x39, 0xB9, 0x79, 0xF9, 0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5,
+    0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5, 0x0D, 0x8D, 0x4D, 0xCD,
+    0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
+    0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3,
+    0x33, 0xB3, 0x73, 0xF3, 0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB,
+    0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB, 0x07, 0x87, 0x47, 0xC7,
+    0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
+    0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF,
+    0x3F, 0xBF, 0x7F, 0xFF};
+#endif
+
+/*!
+ *    @brief  Reverse the order of the bits in every byte of a buffer, e.g. to
+ *    talk to an LSB first device over MSB first hardware
+ *    @param  buffer The bytes to reverse, in place
+ *    @param  len Number of bytes
+ */
+void Adafruit_SPIDevice::reverseBits(uint8_t *buffer, size_t len) {
+#if defined(__AVR__)
+  for (size_t i = 0; i < len; i++) {
+    buffer[i] = pgm_read_byte(&busio_reverse_table[buffer[i]]);
+  }
+#else
+  size_t i = 0;
+  for (; (i + 4) <= len; i += 4) {
+    uint32_t w;
+    memcpy(&w, buffer + i, 4);
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) ||                  \
+    defined(__ARM_ARCH_8M_MAIN__)
+    // RBIT reverses the whole word, REV puts the bytes back in order
+    __asm__("rbit %0, %0" : "+r"(w));
+    w = __builtin_bswap32(w);
+#else
+    // swap neighbouring bits, then pairs, then nibbles, in all 4 bytes at once
+    w = ((w >> 1) & 0x55555555) | ((w & 0x55555555) << 1);
+    w = ((w >> 2) & 0x33333333) | ((w & 0x33333333) << 2);
+    w = ((w >> 4) & 0x0F0F0F0F) | ((w & 0x0F0F0F0F) << 4);
+#endif
+    memcpy(buffer + i, &w, 4);
+  }
+  for (; i < len; i++) {
+    uint8_t b = buffer[i];
+    b = ((b >> 1) & 0x55) | ((b & 0x55) << 1);
+    b = ((b >> 2) & 0x33) | ((b & 0x33) << 2);
+    buffer[i] = (b >> 4) | (b << 4);
+  }
+#endif
+}
+
 /*!
  *    @brief  Transfer (send/receive) one byte over hard/soft SPI, without
  * transaction management
@@ -285,9 +412,20 @@ uint8_t Adafruit_SPIDevice::transfer(uint8_t send) {
  * SPI)
  */
 void Adafruit_SPIDevice::beginTransaction(void) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    uint8_t mode = (_dataMode == SPI_MODE3)   ? 3
+                   : (_dataMode == SPI_MODE2) ? 2
+                   : (_dataMode == SPI_MODE1) ? 1
+                                              : 0;
+    _linux->beginTransaction(_freq, mode,
+                             _dataOrder == SPI_BITORDER_LSBFIRST);
+    return;
+  }
+#endif
   if (_spi) {
 #ifdef BUSIO_HAS_HW_SPI
-    _spi->beginTransaction(*_spiSetting);
+    _spi->beginTransaction(_spiSetting);
 #endif
   }
 }
@@ -296,6 +434,12 @@ void Adafruit_SPIDevice::beginTransaction(void) {
  *    @brief  Manually end a transaction (calls endTransaction if hardware SPI)
  */
 void Adafruit_SPIDevice::endTransaction(void) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    _linux->endTransaction();
+    return;
+  }
+#endif
   if (_spi) {
 #ifdef BUSIO_HAS_HW_SPI
     _spi->endTransaction();
@@ -309,7 +453,7 @@ void Adafruit_SPIDevice::endTransaction(void) {
  */
 void Adafruit_SPIDevice::setChipSelect(int value) {
   if (_cs != -1) {
-    digitalWrite(_cs, value);
+    BUSIO_WRITE_CS(value);
   }
 }
 
@@ -333,6 +477,86 @@ void Adafruit_SPIDevice::endTransactionWithDeassertingCS() {
   endTransaction();
 }
 
+/*!
+ *    @brief  Send a buffer, throwing away what comes back, the fastest way the
+ *    core allows. No transaction management.
+ *    @param  buffer Pointer to buffer of data to write
+ *    @param  len Number of bytes from buffer to write
+ */
+void Adafruit_SPIDevice::_send(const uint8_t *buffer, size_t len) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    _linux->queue(buffer, nullptr, len);
+    return;
+  }
+#endif
+  if (_spi) {
+#ifdef BUSIO_HAS_HW_SPI
+#ifdef BUSIO_SPI_NO_LSBFIRST
+    // the caller's buffer is const, so reverse a piece at a time on the side
+    uint8_t reversed[BUSIO_REPEAT_BURST];
+    bool reverse = BUSIO_HW_REVERSE();
+#endif
+    while (len) {
+      const uint8_t *out = buffer;
+      size_t n = len;
+#ifdef BUSIO_SPI_NO_LSBFIRST
+      if (reverse) {
+        n = (len < sizeof(reversed)) ? len : sizeof(reversed);
+        memcpy(reversed, buffer, n);
+        reverseBits(reversed, n);
+        out = reversed;
+      }
+#endif
+#if (BUSIO_SPI_CAPS & BUSIO_SPI_CAP_TXONLY)
+      BUSIO_SPI_TXONLY(_spi, out, n);
+#else
+      for (size_t i = 0; i < n; i++) {
+        _spi->transfer(out[i]);
+      }
+#endif
+      buffer += n;
+      len -= n;
+    }
+#endif
+    return;
+  }
+  for (size_t i = 0; i < len; i++) {
+    transfer(buffer[i]);
+  }
+}
+
+/*!
+ *    @brief  Transfer a buffer in place as part of a transaction. Unlike
+ *    transfer(), the received bytes may only be there once the transaction
+ *    has ended, which lets the Linux backend send it all in one go.
+ *    @param  buffer The buffer to send and receive at the same time
+ *    @param  len The number of bytes to transfer
+ */
+void Adafruit_SPIDevice::_receive(uint8_t *buffer, size_t len) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    _linux->queue(buffer, buffer, len);
+    return;
+  }
+#endif
+  transfer(buffer, len);
+}
+
+/*!
+ *    @brief  Whether the last transaction went through. Only the Linux
+ *    backend can tell, everything else always says yes
+ *    @return False if the transaction failed
+ */
+bool Adafruit_SPIDevice::_busOk(void) {
+#ifdef BUSIO_HAS_LINUX
+  if (_linux) {
+    return _linux->ok();
+  }
+#endif
+  return true;
+}
+
 /*!
  *    @brief  Write a buffer or two to the SPI device, with transaction
  * management.
@@ -341,33 +565,19 @@ void Adafruit_SPIDevice::endTransactionWithDeassertingCS() {
  *    @param  prefix_buffer Pointer to optional array of data to write before
  * buffer.
  *    @param  prefix_len Number of bytes from prefix buffer to write
- *    @return Always returns true because there's no way to test success of SPI
- * writes
+ *    @return False if the Linux spidev ioctl failed, otherwise true because
+ * there's no way to test success of SPI writes
  */
 bool Adafruit_SPIDevice::write(const uint8_t *buffer, size_t len,
                                const uint8_t *prefix_buffer,
                                size_t prefix_len) {
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_SPI, BUSIO_CAPTURE_WRITE, _cs,
+                      prefix_buffer, prefix_len, buffer, len, nullptr, 0);
   beginTransactionWithAssertingCS();
 
   // do the writing
-#if defined(ARDUINO_ARCH_ESP32)
-  if (_spi) {
-    if (prefix_len > 0) {
-      _spi->transferBytes((uint8_t *)prefix_buffer, nullptr, prefix_len);
-    }
-    if (len > 0) {
-      _spi->transferBytes((uint8_t *)buffer, nullptr, len);
-    }
-  } else
-#endif
-  {
-    for (size_t i = 0; i < prefix_len; i++) {
-      transfer(prefix_buffer[i]);
-    }
-    for (size_t i = 0; i < len; i++) {
-      transfer(buffer[i]);
-    }
-  }
+  _send(prefix_buffer, prefix_len);
+  _send(buffer, len);
   endTransactionWithDeassertingCS();
 
 #ifdef DEBUG_SERIAL
@@ -390,7 +600,7 @@ bool Adafruit_SPIDevice::write(const uint8_t *buffer, size_t len,
   DEBUG_SERIAL.println();
 #endif
 
-  return true;
+  return _track(_busOk());
 }
 
 /*!
@@ -400,14 +610,16 @@ bool Adafruit_SPIDevice::write(const uint8_t *buffer, size_t len,
  *    @param  len Number of bytes from buffer to read.
  *    @param  sendvalue The 8-bits of data to write when doing the data read,
  * defaults to 0xFF
- *    @return Always returns true because there's no way to test success of SPI
- * writes
+ *    @return False if the Linux spidev ioctl failed, otherwise true because
+ * there's no way to test success of SPI writes
  */
 bool Adafruit_SPIDevice::read(uint8_t *buffer, size_t len, uint8_t sendvalue) {
-  memset(buffer, sendvalue, len); // clear out existing buffer
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_SPI, BUSIO_CAPTURE_READ, _cs, nullptr, 0,
+                      nullptr, 0, buffer, len);
 
   beginTransactionWithAssertingCS();
-  transfer(buffer, len);
+  memset(buffer, sendvalue, len); // clear out existing buffer
+  _receive(buffer, len);
   endTransactionWithDeassertingCS();
 
 #ifdef DEBUG_SERIAL
@@ -423,7 +635,7 @@ bool Adafruit_SPIDevice::read(uint8_t *buffer, size_t len, uint8_t sendvalue) {
   DEBUG_SERIAL.println();
 #endif
 
-  return true;
+  return _track(_busOk());
 }
 
 /*!
@@ -436,26 +648,18 @@ bool Adafruit_SPIDevice::read(uint8_t *buffer, size_t len, uint8_t sendvalue) {
  *    @param  read_len Number of bytes from buffer to read.
  *    @param  sendvalue The 8-bits of data to write when doing the data read,
  * defaults to 0xFF
- *    @return Always returns true because there's no way to test success of SPI
- * writes
+ *    @return False if the Linux spidev ioctl failed, otherwise true because
+ * there's no way to test success of SPI writes
  */
 bool Adafruit_SPIDevice::write_then_read(const uint8_t *write_buffer,
                                          size_t write_len, uint8_t *read_buffer,
                                          size_t read_len, uint8_t sendvalue) {
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_SPI, BUSIO_CAPTURE_WRITE_THEN_READ, _cs,
+                      nullptr, 0, write_buffer, write_len, read_buffer,
+                      read_len);
   beginTransactionWithAssertingCS();
   // do the writing
-#if defined(ARDUINO_ARCH_ESP32)
-  if (_spi) {
-    if (write_len > 0) {
-      _spi->transferBytes((uint8_t *)write_buffer, nullptr, write_len);
-    }
-  } else
-#endif
-  {
-    for (size_t i = 0; i < write_len; i++) {
-      transfer(write_buffer[i]);
-    }
-  }
+  _send(write_buffer, write_len);
 
 #ifdef DEBUG_SERIAL
   DEBUG_SERIAL.print(F("\tSPIDevice Wrote: "));
@@ -471,9 +675,11 @@ bool Adafruit_SPIDevice::write_then_read(const uint8_t *write_buffer,
 #endif
 
   // do the reading
-  for (size_t i = 0; i < read_len; i++) {
-    read_buffer[i] = transfer(sendvalue);
+  if (read_len) {
+    memset(read_buffer, sendvalue, read_len);
+    _receive(read_buffer, read_len);
   }
+  endTransactionWithDeassertingCS();
 
 #ifdef DEBUG_SERIAL
   DEBUG_SERIAL.print(F("\tSPIDevice Read: "));
@@ -488,9 +694,7 @@ bool Adafruit_SPIDevice::write_then_read(const uint8_t *write_buffer,
   DEBUG_SERIAL.println();
 #endif
 
-  endTransactionWithDeassertingCS();
-
-  return true;
+  return _track(_busOk());
 }
 
 /*!
@@ -500,13 +704,263 @@ bool Adafruit_SPIDevice::write_then_read(const uint8_t *write_buffer,
  * transmit-receive at the same time!
  *    @param  buffer Pointer to buffer of data to write/read to/from
  *    @param  len Number of bytes from buffer to write/read.
- *    @return Always returns true because there's no way to test success of SPI
- * writes
+ *    @return False if the Linux spidev ioctl failed, otherwise true because
+ * there's no way to test success of SPI writes
  */
 bool Adafruit_SPIDevice::write_and_read(uint8_t *buffer, size_t len) {
+  BUSIO_CAPTURE_START(BUSIO_CAPTURE_SPI, BUSIO_CAPTURE_TRANSFER, _cs, nullptr,
+                      0, buffer, len, buffer, len);
   beginTransactionWithAssertingCS();
-  transfer(buffer, len);
+  _receive(buffer, len);
+  endTransactionWithDeassertingCS();
+
+  return _track(_busOk());
+}
+
+#if defined(BUSIO_HAS_HW_SPI) && (BUSIO_SPI_CAPS & BUSIO_SPI_CAP_DMA)
+static volatile bool spi_stream_busy = false; // a background chunk is going
+
+static void spi_stream_done(void) { spi_stream_busy = false; }
+#endif
+
+/*!
+ *    @brief  Write a payload too big to hold in RAM all at once, a chunk at a
+ *    time, with CS held low throughout. The producer fills one buffer while
+ *    the other one goes out, in the background where the core can do DMA
+ *    (only one stream at a time then), otherwise taking turns. Not recorded
+ *    by Adafruit_BusIO_Capture.
+ *    @param  producer Called for each chunk until it returns 0
+ *    @param  arg Argument handed to the producer
+ *    @param  buffer0 Buffer of chunk bytes
+ *    @param  buffer1 Second buffer of chunk bytes, or nullptr to fill and send
+ *    from buffer0 only
+ *    @param  chunk Size of each buffer
+ *    @param  prefix_buffer Pointer to optional array of data to write first,
+ *    e.g. a command
+ *    @param  prefix_len Number of bytes from prefix buffer to write
+ *    @return False if the Linux spidev ioctl failed, otherwise true because
+ * there's no way to test success of SPI writes
+ */
+bool Adafruit_SPIDevice::writeStream(busio_spi_producer_t producer, void *arg,
+                                     uint8_t *buffer0, uint8_t *buffer1,
+                                     size_t chunk,
+                                     const uint8_t *prefix_buffer,
+                                     size_t prefix_len) {
+  uint8_t *buffers[2] = {buffer0, buffer1 ? buffer1 : buffer0};
+  uint8_t cur = 0;
+
+  beginTransactionWithAssertingCS();
+  _send(prefix_buffer, prefix_len);
+
+  size_t len = producer(arg, buffers[cur], chunk);
+  while (len) {
+    if (len > chunk) {
+      len = chunk;
+    }
+#if defined(BUSIO_HAS_HW_SPI) && (BUSIO_SPI_CAPS & BUSIO_SPI_CAP_DMA)
+    if (_spi && buffer1) {
+      if (BUSIO_HW_REVERSE()) {
+        reverseBits(buffers[cur], len);
+      }
+      spi_stream_busy = true;
+      BUSIO_SPI_TXSTART(_spi, buffers[cur], len, spi_stream_done);
+      cur ^= 1;
+      len = producer(arg, buffers[cur], chunk);
+      while (spi_stream_busy) {
+        yield();
+      }
+      continue;
+    }
+#endif
+    _send(buffers[cur], len);
+#ifdef BUSIO_HAS_LINUX
+    if (_linux) {
+      _linux->flush(true); // the producer is about to refill the buffer
+    }
+#endif
+    if (buffer1) {
+      cur ^= 1;
+    }
+    len = producer(arg, buffers[cur], chunk);
+  }
+
   endTransactionWithDeassertingCS();
+  return _track(_busOk(), false);
+}
+
+/*!
+ *    @brief  Write a byte or word pattern over and over, e.g. to clear a
+ *    display, without a buffer the size of the whole fill. CS is held low
+ *    throughout, so the device sees one write. Not recorded by
+ *    Adafruit_BusIO_Capture.
+ *    @param  pattern The bytes to repeat
+ *    @param  pattern_len Number of bytes in the pattern, at most
+ *    BUSIO_REPEAT_BURST
+ *    @param  count How many times to write the pattern
+ *    @param  prefix_buffer Pointer to optional array of data to write first,
+ *    e.g. a command
+ *    @param  prefix_len Number of bytes from prefix buffer to write
+ *    @return False if the pattern is too long, otherwise true because there's
+ *    no way to test success of SPI writes
+ */
+bool Adafruit_SPIDevice::writeRepeated(const uint8_t *pattern,
+                                       size_t pattern_len, size_t count,
+                                       const uint8_t *prefix_buffer,
+                                       size_t prefix_len) {
+  uint8_t burst[BUSIO_REPEAT_BURST];
+  if ((pattern_len == 0) || (pattern_len > sizeof(burst))) {
+    return false;
+  }
+
+  beginTransactionWithAssertingCS();
+  _send(prefix_buffer, prefix_len);
 
+#if defined(BUSIO_HAS_HW_SPI) && (BUSIO_SPI_CAPS & BUSIO_SPI_CAP_PATTERN)
+  if (_spi && !BUSIO_HW_REVERSE() && (pattern_len <= BUSIO_SPI_PATTERN_MAX)) {
+    BUSIO_SPI_PATTERN(_spi, pattern, pattern_len, count);
+    count = 0;
+  }
+#endif
+
+  size_t per_burst = sizeof(burst) / pattern_len;
+  size_t fill = (per_burst < count) ? per_burst : count;
+  for (size_t i = 0; i < fill; i++) {
+    memcpy(burst + i * pattern_len, pattern, pattern_len);
+  }
+  while (count) {
+    size_t n = (count < per_burst) ? count : per_burst;
+    _send(burst, n * pattern_len);
+    count -= n;
+  }
+
+  endTransactionWithDeassertingCS();
+  return _track(_busOk(), false);
+}
+
+/*!
+ *    @brief  Run several transfers as one transaction, e.g. a command, its
+ *    reply and the next command, letting go of CS only after the segments
+ *    that ask for it. On a Linux spidev bus this is a single system call.
+ *    Not recorded by Adafruit_BusIO_Capture.
+ *    @param  segments The transfers, in order
+ *    @param  count Number of segments
+ *    @return False if the Linux spidev ioctl failed, otherwise true because
+ *    there's no way to test success of SPI writes
+ */
+bool Adafruit_SPIDevice::transferBatch(const busio_spi_segment_t *segments,
+                                       uint8_t count) {
+  beginTransactionWithAssertingCS();
+  for (uint8_t i = 0; i < count; i++) {
+    const busio_spi_segment_t *seg = &segments[i];
+    bool last = (i + 1) == count;
+#ifdef BUSIO_HAS_LINUX
+    if (_linux) {
+      _linux->queue(seg->tx, seg->rx, seg->len, seg->cs_change && !last);
+      continue;
+    }
+#endif
+    if (seg->rx) {
+      if (!seg->tx) {
+        memset(seg->rx, 0x00, seg->len);
+      } else if (seg->tx != seg->rx) {
+        memmove(seg->rx, seg->tx, seg->len);
+      }
+      transfer(seg->rx, seg->len);
+    } else if (seg->tx) {
+      _send(seg->tx, seg->len);
+    } else {
+      for (size_t n = 0; n < seg->len; n++) {
+        transfer((uint8_t)0x00);
+      }
+    }
+    if (seg->cs_change && !last) {
+      endTransactionWithDeassertingCS();
+      beginTransactionWithAssertingCS();
+    }
+  }
+  endTransactionWithDeassertingCS();
+  return _track(_busOk(), false);
+}
+
+/*!
+ *    @brief  Change the SPI clock frequency for the following transactions
+ *    @param  freq The SPI clock frequency to use, in Hz
+ *    @return Always true, the bus settings are only checked by the core
+ */
+bool Adafruit_SPIDevice::setSpeed(uint32_t freq) {
+  _freq = freq;
+#ifdef BUSIO_HAS_HW_SPI
+  _spiSetting = SPISettings(freq, BUSIO_HW_BITORDER(_dataOrder), _dataMode);
+#endif
   return true;
 }
+
+/*!
+ *    @brief  Find the fastest clock this device works at over the wiring it
+ *    is on, by stepping the clock up 25% at a time while reading back a
+ *    register with a known value, then taking a safety margin off the fastest
+ *    clock that passed. The device is left running at the result.
+ *    @param  reg A register on this device with a known value, e.g. its ID
+ *    @param  expected The value reg must read back as
+ *    @param  min_freq The clock to start at, in Hz
+ *    @param  max_freq The clock not to go past, in Hz
+ *    @param  margin_pct How many percent to take off the fastest passing clock
+ *    @param  reads How many reads in a row must match at each step
+ *    @return The clock now in use in Hz, or 0 if even min_freq failed (the
+ *    previous clock is restored then)
+ */
+uint32_t Adafruit_SPIDevice::calibrateSpeed(Adafruit_BusIO_Register *reg,
+                                            uint32_t expected,
+                                            uint32_t min_freq,
+                                            uint32_t max_freq,
+                                            uint8_t margin_pct, uint8_t reads) {
+  uint32_t previous = _freq, best = 0;
+
+  for (uint32_t freq = min_freq; freq && (freq <= max_freq);
+       freq = _tuner.step(freq)) {
+    setSpeed(freq);
+    if (!_tuner.verify(reg, expected, reads)) {
+      break;
+    }
+    best = freq;
+  }
+
+  best = _tuner.settle(min_freq, best, margin_pct);
+  setSpeed(best ? best : previous);
+  return best;
+}
+
+/*!
+ *    @brief  Step the clock down 25% (but not under the calibration minimum,
+ *    or 1MHz before any calibration) whenever too many transactions fail.
+ *    SPI can't tell a bad transfer by itself, so failures come from
+ *    reportError()
+ *    @param  max_errors How many reported errors within the window trigger a
+ *    step down, 0 to turn this off
+ *    @param  window How many transactions make up the window
+ */
+void Adafruit_SPIDevice::setSpeedBackoff(uint8_t max_errors, uint8_t window) {
+  _tuner.setBackoff(max_errors, window);
+}
+
+/*!
+ *    @brief  Tell the device a transaction came back bad (CRC mismatch,
+ *    impossible value...) so it counts towards the speed backoff as a
+ *    failure, not as one more transaction
+ */
+void Adafruit_SPIDevice::reportError(void) { _tuner.fail(); }
+
+/*!
+ *    @brief  Count a finished transaction towards the error rate, slowing the
+ *    clock down if setSpeedBackoff() says so
+ *    @param  ok Whether the transaction went through
+ *    @param  captured False if the call made no BUSIO_CAPTURE_START
+ *    @return ok, so this can wrap the return value
+ */
+bool Adafruit_SPIDevice::_track(bool ok, bool captured) {
+  uint32_t freq = _tuner.record(ok, _freq);
+  if (freq) {
+    setSpeed(freq);
+  }
+  return captured ? BUSIO_CAPTURE_END(ok) : ok;
+}
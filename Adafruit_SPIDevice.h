@@ -1,6 +1,8 @@
 #ifndef Adafruit_SPIDevice_h
 #define Adafruit_SPIDevice_h
 
+#include <Adafruit_BusIO_FastPinIO.h>
+#include <Adafruit_BusIO_SpeedTuner.h>
 #include <Arduino.h>
 
 #if !defined(SPI_INTERFACES_COUNT) ||                                          \
@@ -8,6 +10,7 @@
 // HW SPI available
 #include <SPI.h>
 #define BUSIO_HAS_HW_SPI
+#include <Adafruit_BusIO_SPICaps.h>
 #else
 // SW SPI ONLY
 enum { SPI_MODE0, SPI_MODE1, SPI_MODE2, SPI_MODE3 };
@@ -46,51 +49,50 @@ typedef enum _BitOrder {
 typedef BitOrder BusIOBitOrder;
 #endif
 
-#if defined(__IMXRT1062__) // Teensy 4.x
-// *Warning* I disabled the usage of FAST_PINIO as the set/clear operations
-// used in the cpp file are not atomic and can effect multiple IO pins
-// and if an interrupt happens in between the time the code reads the register
-//  and writes out the updated value, that changes one or more other IO pins
-// on that same IO port, those change will be clobbered when the updated
-// values are written back.  A fast version can be implemented that uses the
-// ports set and clear registers which are atomic.
-// typedef volatile uint32_t BusIO_PortReg;
-// typedef uint32_t BusIO_PortMask;
-// #define BUSIO_USE_FAST_PINIO
-
-#elif defined(__MBED__) || defined(__ZEPHYR__)
-// Boards based on RTOS cores like mbed or Zephyr are not going to expose the
-// low level registers needed for fast pin manipulation
-#undef BUSIO_USE_FAST_PINIO
-
-#elif defined(ARDUINO_ARCH_XMC)
-#undef BUSIO_USE_FAST_PINIO
-
-#elif defined(__AVR__) || defined(TEENSYDUINO)
-typedef volatile uint8_t BusIO_PortReg;
-typedef uint8_t BusIO_PortMask;
-#define BUSIO_USE_FAST_PINIO
-
-#elif defined(ESP8266) || defined(ESP32) || defined(__SAM3X8E__) ||            \
-    defined(ARDUINO_ARCH_SAMD)
-typedef volatile uint32_t BusIO_PortReg;
-typedef uint32_t BusIO_PortMask;
-#define BUSIO_USE_FAST_PINIO
-
-#elif (defined(__arm__) || defined(ARDUINO_FEATHER52)) &&                      \
-    !defined(ARDUINO_ARCH_RP2040) && !defined(ARDUINO_SILABS) &&               \
-    !defined(ARDUINO_UNOR4_MINIMA) && !defined(ARDUINO_UNOR4_WIFI) &&          \
-    !defined(PORTDUINO)
-typedef volatile uint32_t BusIO_PortReg;
-typedef uint32_t BusIO_PortMask;
-#if !defined(__ASR6501__) && !defined(__ASR6502__)
-#define BUSIO_USE_FAST_PINIO
+// Upper bound on sizeof(Adafruit_SPIDevice), checked when the library is
+// built. Sketches make lots of these, so growing it should be on purpose
+#ifndef BUSIO_SPIDEVICE_MAX_SIZE
+#if defined(__AVR__)
+#define BUSIO_SPIDEVICE_MAX_SIZE 48
+#else
+#define BUSIO_SPIDEVICE_MAX_SIZE 128
+#endif
 #endif
 
-#else
-#undef BUSIO_USE_FAST_PINIO
+///< Stack buffer writeRepeated() builds its bursts in, bigger is faster
+#ifndef BUSIO_REPEAT_BURST
+#define BUSIO_REPEAT_BURST 32
 #endif
 
+// Linux boards get i2c-dev and spidev buses, see Adafruit_BusIO_Linux.h.
+// Define BUSIO_NO_LINUX to leave them out
+#if !defined(BUSIO_HAS_LINUX) && defined(__linux__) && !defined(BUSIO_NO_LINUX)
+#define BUSIO_HAS_LINUX
+#endif
+
+class Adafruit_LinuxSPI;
+
+/*!
+ * @brief Fills the next chunk of a writeStream()
+ * @param arg The argument given to writeStream()
+ * @param buffer Where to put the bytes
+ * @param maxlen How many bytes fit
+ * @return How many bytes were put in, 0 when there are no more
+ */
+typedef size_t (*busio_spi_producer_t)(void *arg, uint8_t *buffer,
+                                       size_t maxlen);
+
+/*!
+ * @brief One piece of a transferBatch(). Segments go out back to back with
+ * CS held, unless cs_change says to let go of it in between
+ */
+typedef struct {
+  const uint8_t *tx; ///< Bytes to send, or nullptr to send zeros
+  uint8_t *rx;       ///< Where to put received bytes, or nullptr. May be tx
+  size_t len;        ///< Number of bytes
+  bool cs_change;    ///< Let go of CS for a moment after this segment
+} busio_spi_segment_t;
+
 /**! The class which defines how we will talk to this device over SPI **/
 class Adafruit_SPIDevice {
 public:
@@ -107,7 +109,11 @@ public:
                      uint32_t freq = 1000000,
                      BusIOBitOrder dataOrder = SPI_BITORDER_MSBFIRST,
                      uint8_t dataMode = SPI_MODE0);
-  ~Adafruit_SPIDevice();
+#ifdef BUSIO_HAS_LINUX
+  Adafruit_SPIDevice(Adafruit_LinuxSPI *spidev, uint32_t freq = 1000000,
+                     BusIOBitOrder dataOrder = SPI_BITORDER_MSBFIRST,
+                     uint8_t dataMode = SPI_MODE0);
+#endif
 
   bool begin(void);
   bool read(uint8_t *buffer, size_t len, uint8_t sendvalue = 0xFF);
@@ -117,6 +123,16 @@ public:
                        uint8_t *read_buffer, size_t read_len,
                        uint8_t sendvalue = 0xFF);
   bool write_and_read(uint8_t *buffer, size_t len);
+  bool writeStream(busio_spi_producer_t producer, void *arg, uint8_t *buffer0,
+                   uint8_t *buffer1, size_t chunk,
+                   const uint8_t *prefix_buffer = nullptr,
+                   size_t prefix_len = 0);
+  bool writeRepeated(const uint8_t *pattern, size_t pattern_len, size_t count,
+                     const uint8_t *prefix_buffer = nullptr,
+                     size_t prefix_len = 0);
+  bool transferBatch(const busio_spi_segment_t *segments, uint8_t count);
+
+  static void reverseBits(uint8_t *buffer, size_t len);
 
   uint8_t transfer(uint8_t send);
   void transfer(uint8_t *buffer, size_t len);
@@ -125,18 +141,39 @@ public:
   void beginTransactionWithAssertingCS();
   void endTransactionWithDeassertingCS();
 
+  bool setSpeed(uint32_t freq);
+  uint32_t calibrateSpeed(Adafruit_BusIO_Register *reg, uint32_t expected,
+                          uint32_t min_freq = 1000000,
+                          uint32_t max_freq = 20000000,
+                          uint8_t margin_pct = 20, uint8_t reads = 8);
+  void setSpeedBackoff(uint8_t max_errors, uint8_t window = 32);
+  void reportError(void);
+  /*!   @brief  The speed picked by calibrateSpeed(), e.g. to store it away and
+   *    hand it to setSpeed() on the next boot
+   *    @return The calibrated clock in Hz, 0 if never calibrated */
+  uint32_t calibratedSpeed(void) { return _tuner.calibrated(); }
+
 private:
+  friend class Adafruit_BusIO_DeviceGroup; // drives several CS lines at once
+
 #ifdef BUSIO_HAS_HW_SPI
   SPIClass *_spi = nullptr;
-  SPISettings *_spiSetting = nullptr;
+  SPISettings _spiSetting; // kept in place so constructing us never allocates
 #else
   uint8_t *_spi = nullptr;
-  uint8_t *_spiSetting = nullptr;
+#endif
+#ifdef BUSIO_HAS_LINUX
+  Adafruit_LinuxSPI *_linux = nullptr;
 #endif
   uint32_t _freq;
   BusIOBitOrder _dataOrder;
   uint8_t _dataMode;
   void setChipSelect(int value);
+  void _send(const uint8_t *buffer, size_t len);
+  void _receive(uint8_t *buffer, size_t len);
+  bool _busOk(void);
+  bool _track(bool ok, bool captured = true);
+  Adafruit_BusIO_SpeedTuner _tuner{1000000}; // backs off to the default
 
   int8_t _cs, _sck, _mosi, _miso;
 #ifdef BUSIO_USE_FAST_PINIO
@@ -0,0 +1,445 @@
+#include "Adafruit_SoftI2C.h"
+#include "Adafruit_BusIO_CRC.h"
+
+// #define DEBUG_SERIAL Serial
+
+/*!
+ *    @brief  Create a software I2C bus on two GPIO pins
+ *    @param  sdapin The arduino pin number to use for SDA
+ *    @param  sclpin The arduino pin number to use for SCL
+ *    @param  freq The SCL frequency to aim for, defaults to 100KHz. See
+ * setClock() for the fastest it gets
+ */
+Adafruit_SoftI2C::Adafruit_SoftI2C(int8_t sdapin, int8_t sclpin,
+                                   uint32_t freq) {
+  _sda = sdapin;
+  _scl = sclpin;
+  _stretch_timeout_us = 25000; // SMBus clock low timeout
+  _begun = false;
+  _active = false;
+  _pec = false;
+  _pec_crc = 0;
+  _error = BUSIO_I2C_OK;
+  setClock(freq);
+
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  sdaMode = (BusIO_PortReg *)portModeRegister(digitalPinToPort(sdapin));
+  sdaIn = (BusIO_PortReg *)portInputRegister(digitalPinToPort(sdapin));
+  sdaPinMask = digitalPinToBitMask(sdapin);
+  sclMode = (BusIO_PortReg *)portModeRegister(digitalPinToPort(sclpin));
+  sclIn = (BusIO_PortReg *)portInputRegister(digitalPinToPort(sclpin));
+  sclPinMask = digitalPinToBitMask(sclpin);
+#endif
+}
+
+/*!
+ *    @brief  Release both lines and get ready for transactions
+ *    @return True if the bus is idle (both lines float high)
+ */
+bool Adafruit_SoftI2C::begin(void) {
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  // drive-low level is latched once, we then only toggle the direction
+  BusIO_PortReg *out;
+  out = (BusIO_PortReg *)portOutputRegister(digitalPinToPort(_sda));
+  *out = *out & ~sdaPinMask;
+  out = (BusIO_PortReg *)portOutputRegister(digitalPinToPort(_scl));
+  *out = *out & ~sclPinMask;
+#endif
+  _sdaRelease();
+  _sclRelease();
+  _active = false;
+  _begun = true;
+
+  _halfDelay();
+  return _sdaRead() && _sclRead();
+}
+
+/*!
+ *    @brief  Let go of both lines
+ */
+void Adafruit_SoftI2C::end(void) {
+  pinMode(_sda, INPUT);
+  pinMode(_scl, INPUT);
+  _active = false;
+  _begun = false;
+}
+
+/*!
+ *    @brief  Change the SCL frequency. The delay is counted in whole
+ * microseconds, rounded up so the bus never runs faster than asked, with at
+ * least 1us per half clock. That makes 500KHz the top rate (less the time
+ * the pins take to toggle), and 400KHz runs at 250KHz: Fast-mode Plus is
+ * not supported
+ *    @param  freq The desired SCL frequency
+ */
+void Adafruit_SoftI2C::setClock(uint32_t freq) {
+  if (freq == 0) {
+    freq = 100000;
+  }
+  _halfperiod_us = (500000UL + freq - 1) / freq;
+}
+
+/*!
+ *    @brief  Set how long a device may stretch the clock before we give up
+ *    @param  timeout_us The maximum time SCL may be held low, in microseconds,
+ *    0 for the SMBus clock low timeout of 25ms
+ */
+void Adafruit_SoftI2C::setClockStretchTimeout(uint32_t timeout_us) {
+  _stretch_timeout_us = timeout_us ? timeout_us : 25000;
+}
+
+/*!
+ *    @brief  Turn SMBus Packet Error Checking on or off. When on, the PEC
+ * byte is worked out bit by bit as the transaction goes over the wire: it is
+ * sent after the data of a write that ends with a STOP, and read and checked
+ * after the data of every read
+ *    @param  enable True to send and check PEC bytes
+ */
+void Adafruit_SoftI2C::setPEC(bool enable) { _pec = enable; }
+
+/*!
+ *    @brief  See if a device ACKs its address
+ *    @param  addr The 7-bit I2C address to check
+ *    @return True if the address was ACK'd
+ */
+bool Adafruit_SoftI2C::probe(uint8_t addr) {
+  bool ack = _address(addr, false);
+  _stop();
+  return ack;
+}
+
+/*!
+ *    @brief  Write a buffer or two to a device in one transaction. There is no
+ * transmit buffer so there is no limit on the length
+ *    @param  addr The 7-bit I2C address of the device
+ *    @param  buffer Pointer to buffer of data to write
+ *    @param  len Number of bytes from buffer to write
+ *    @param  stop Whether to send an I2C STOP signal on write. If not, the next
+ * transaction begins with a repeated START
+ *    @param  prefix_buffer Pointer to optional array of data to write before
+ * buffer
+ *    @param  prefix_len Number of bytes from prefix buffer to write
+ *    @return True if the device ACK'd everything
+ */
+bool Adafruit_SoftI2C::write(uint8_t addr, const uint8_t *buffer, size_t len,
+                             bool stop, const uint8_t *prefix_buffer,
+                             size_t prefix_len) {
+  if (!_address(addr, false)) {
+    _stop();
+    return false;
+  }
+
+  if (prefix_buffer != nullptr) {
+    for (size_t i = 0; i < prefix_len; i++) {
+      if (!_writeData(prefix_buffer[i])) {
+        _stop();
+        return false;
+      }
+    }
+  }
+  for (size_t i = 0; i < len; i++) {
+    if (!_writeData(buffer[i])) {
+      _stop();
+      return false;
+    }
+  }
+
+  if (stop && _pec && !_writeData(_pec_crc)) {
+    _stop();
+    return false;
+  }
+
+  if (stop) {
+    return _stop();
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Read from a device into a buffer in one transaction
+ *    @param  addr The 7-bit I2C address of the device
+ *    @param  buffer Pointer to buffer of data to read into
+ *    @param  len Number of bytes to read
+ *    @param  stop Whether to send an I2C STOP signal after the read
+ *    @return True if the device ACK'd its address and all bytes were clocked in
+ */
+bool Adafruit_SoftI2C::read(uint8_t addr, uint8_t *buffer, size_t len,
+                            bool stop) {
+  if (!_address(addr, true)) {
+    _stop();
+    return false;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    // ACK every byte but the last one, the PEC byte is last if there is one
+    if (!_readByte(&buffer[i], _pec || (i < (len - 1)))) {
+      _stop();
+      return false;
+    }
+  }
+
+  if (_pec) {
+    uint8_t expected = _pec_crc, pec;
+    if (!_readByte(&pec, false)) {
+      _stop();
+      return false;
+    }
+    if (pec != expected) {
+      _error = BUSIO_I2C_ERR_PEC;
+      _stop();
+      return false;
+    }
+  }
+
+  if (stop) {
+    return _stop();
+  }
+  return true;
+}
+
+/*!
+ *    @brief  Try to unstick a device that is holding SDA low (e.g. we reset
+ * in the middle of a read) by clocking SCL up to 9 times, then sending a STOP
+ *    @return True if both lines are released afterwards
+ */
+bool Adafruit_SoftI2C::recoverBus(void) {
+  if (!_begun) {
+    begin();
+  }
+
+  _sdaRelease();
+  for (uint8_t i = 0; (i < 9) && !_sdaRead(); i++) {
+    _sclLow();
+    _halfDelay();
+    if (!_sclRelease()) {
+      _error = BUSIO_I2C_ERR_TIMEOUT;
+      return false;
+    }
+    _halfDelay();
+  }
+
+  _sclLow();
+  _halfDelay();
+  _stop();
+  if (!_sdaRead() || !_sclRead()) {
+    _error = BUSIO_I2C_ERR_ARB_LOST;
+    return false;
+  }
+  _error = BUSIO_I2C_OK;
+  return true;
+}
+
+/**************************************************************************/
+// Line control. Lines are never driven high: 'release' lets the pullup do it
+
+void Adafruit_SoftI2C::_sdaLow(void) {
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  *sdaMode = *sdaMode | sdaPinMask;
+#else
+  digitalWrite(_sda, LOW); // latch LOW first, never drive the line high
+  pinMode(_sda, OUTPUT);
+#endif
+}
+
+void Adafruit_SoftI2C::_sdaRelease(void) {
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  *sdaMode = *sdaMode & ~sdaPinMask;
+#else
+  pinMode(_sda, INPUT);
+#endif
+}
+
+bool Adafruit_SoftI2C::_sdaRead(void) {
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  return *sdaIn & sdaPinMask;
+#else
+  return digitalRead(_sda);
+#endif
+}
+
+void Adafruit_SoftI2C::_sclLow(void) {
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  *sclMode = *sclMode | sclPinMask;
+#else
+  digitalWrite(_scl, LOW); // latch LOW first, never drive the line high
+  pinMode(_scl, OUTPUT);
+#endif
+}
+
+bool Adafruit_SoftI2C::_sclRead(void) {
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  return *sclIn & sclPinMask;
+#else
+  return digitalRead(_scl);
+#endif
+}
+
+/*
+ * Release SCL and wait for it to actually go high, devices are allowed to
+ * hold it low (clock stretching) while they get the next byte ready
+ */
+bool Adafruit_SoftI2C::_sclRelease(void) {
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  *sclMode = *sclMode & ~sclPinMask;
+#else
+  pinMode(_scl, INPUT);
+#endif
+
+  if (_sclRead()) {
+    return true;
+  }
+  uint32_t start = micros();
+  while (!_sclRead()) {
+    if ((micros() - start) > _stretch_timeout_us) {
+      _error = BUSIO_I2C_ERR_TIMEOUT;
+#ifdef DEBUG_SERIAL
+      DEBUG_SERIAL.println(F("\tSoftI2C clock stretch timeout"));
+#endif
+      return false;
+    }
+  }
+  return true;
+}
+
+void Adafruit_SoftI2C::_halfDelay(void) { delayMicroseconds(_halfperiod_us); }
+
+/**************************************************************************/
+// Bus conditions and byte transfers
+
+bool Adafruit_SoftI2C::_start(void) {
+  if (!_begun) {
+    begin();
+  }
+  if (!_active) {
+    _pec_crc = 0; // a repeated start carries on the same PEC
+  }
+  if (_active) {
+    // repeated start: bring SDA then SCL back up while SCL is low
+    _sdaRelease();
+    _halfDelay();
+    if (!_sclRelease()) {
+      return false;
+    }
+    _halfDelay();
+  }
+  if (!_sdaRead()) {
+    // someone else is holding the bus
+    _error = BUSIO_I2C_ERR_ARB_LOST;
+    return false;
+  }
+  _sdaLow();
+  _halfDelay();
+  _sclLow();
+  _active = true;
+  return true;
+}
+
+bool Adafruit_SoftI2C::_stop(void) {
+  _active = false;
+  _sdaLow();
+  _halfDelay();
+  if (!_sclRelease()) {
+    return false;
+  }
+  _halfDelay();
+  _sdaRelease();
+  _halfDelay();
+  return _sdaRead();
+}
+
+bool Adafruit_SoftI2C::_writeByte(uint8_t data, bool *ack) {
+  if (_pec) {
+    _pec_crc = Adafruit_BusIO_CRC::smbus(_pec_crc, &data, 1);
+  }
+  for (uint8_t b = 0x80; b != 0; b >>= 1) {
+    if (data & b) {
+      _sdaRelease();
+    } else {
+      _sdaLow();
+    }
+    _halfDelay();
+    if (!_sclRelease()) {
+      return false;
+    }
+    _halfDelay();
+    _sclLow();
+  }
+
+  // ninth clock, the device pulls SDA low to ACK
+  _sdaRelease();
+  _halfDelay();
+  if (!_sclRelease()) {
+    return false;
+  }
+  _halfDelay();
+  *ack = !_sdaRead();
+  _sclLow();
+  return true;
+}
+
+bool Adafruit_SoftI2C::_writeData(uint8_t data) {
+  bool ack;
+
+  if (!_writeByte(data, &ack)) {
+    return false;
+  }
+  if (!ack) {
+    _error = BUSIO_I2C_ERR_DATA_NACK;
+  }
+  return ack;
+}
+
+bool Adafruit_SoftI2C::_readByte(uint8_t *data, bool ack) {
+  uint8_t reply = 0;
+
+  _sdaRelease();
+  for (uint8_t b = 0x80; b != 0; b >>= 1) {
+    _halfDelay();
+    if (!_sclRelease()) {
+      return false;
+    }
+    _halfDelay();
+    if (_sdaRead()) {
+      reply |= b;
+    }
+    _sclLow();
+  }
+
+  // ninth clock, we ACK to ask for more or NACK to finish up
+  if (ack) {
+    _sdaLow();
+  }
+  _halfDelay();
+  if (!_sclRelease()) {
+    return false;
+  }
+  _halfDelay();
+  _sclLow();
+  _sdaRelease();
+
+  if (_pec) {
+    _pec_crc = Adafruit_BusIO_CRC::smbus(_pec_crc, &reply, 1);
+  }
+  *data = reply;
+  return true;
+}
+
+bool Adafruit_SoftI2C::_address(uint8_t addr, bool read) {
+  bool ack;
+
+  _error = BUSIO_I2C_OK;
+  if (!_start()) {
+    return false;
+  }
+  if (!_writeByte((addr << 1) | (read ? 1 : 0), &ack)) {
+    return false;
+  }
+  if (!ack) {
+    _error = BUSIO_I2C_ERR_ADDR_NACK;
+#ifdef DEBUG_SERIAL
+    DEBUG_SERIAL.print(F("\tSoftI2C no ACK from 0x"));
+    DEBUG_SERIAL.println(addr, HEX);
+#endif
+  }
+  return ack;
+}
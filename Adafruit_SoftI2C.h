@@ -0,0 +1,64 @@
+#ifndef Adafruit_SoftI2C_h
+#define Adafruit_SoftI2C_h
+
+#include <Adafruit_BusIO_FastPinIO.h>
+#include <Adafruit_I2CDevice.h>
+#include <Arduino.h>
+
+/*!
+ * @brief A bit-banged I2C master on any two GPIO pins, usable as the bus for
+ * Adafruit_I2CDevice when we run out of (or need more) hardware I2C ports.
+ * Both lines are driven open-drain and need pullups, same as a real I2C bus.
+ */
+class Adafruit_SoftI2C {
+public:
+  Adafruit_SoftI2C(int8_t sdapin, int8_t sclpin, uint32_t freq = 100000);
+
+  bool begin(void);
+  void end(void);
+  void setClock(uint32_t freq);
+  void setClockStretchTimeout(uint32_t timeout_us);
+  void setPEC(bool enable);
+
+  bool probe(uint8_t addr);
+  bool write(uint8_t addr, const uint8_t *buffer, size_t len, bool stop = true,
+             const uint8_t *prefix_buffer = nullptr, size_t prefix_len = 0);
+  bool read(uint8_t addr, uint8_t *buffer, size_t len, bool stop = true);
+  bool recoverBus(void);
+
+  /*!   @brief  Why the last transaction failed
+   *    @return The error from the last probe/read/write */
+  Adafruit_BusIO_I2CError lastError(void) { return _error; }
+
+private:
+  int8_t _sda, _scl;
+  uint16_t _halfperiod_us;
+  uint32_t _stretch_timeout_us;
+  bool _begun;
+  bool _active; // true if the last transaction ended without a STOP
+  bool _pec;
+  uint8_t _pec_crc; // running SMBus PEC of the current transaction
+  Adafruit_BusIO_I2CError _error;
+
+#ifdef BUSIO_USE_FAST_OPENDRAIN
+  BusIO_PortReg *sdaMode, *sclMode, *sdaIn, *sclIn;
+  BusIO_PortMask sdaPinMask, sclPinMask;
+#endif
+
+  void _sdaLow(void);
+  void _sdaRelease(void);
+  bool _sdaRead(void);
+  void _sclLow(void);
+  bool _sclRelease(void);
+  bool _sclRead(void);
+  void _halfDelay(void);
+
+  bool _start(void);
+  bool _stop(void);
+  bool _writeByte(uint8_t data, bool *ack);
+  bool _writeData(uint8_t data);
+  bool _readByte(uint8_t *data, bool ack);
+  bool _address(uint8_t addr, bool read);
+};
+
+#endif // Adafruit_SoftI2C_h
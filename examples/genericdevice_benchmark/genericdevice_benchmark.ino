@@ -0,0 +1,95 @@
+/*
+  Compare the per-call overhead of the function pointer GenericDevice with
+  the templated Adafruit_GenericDeviceT, using a transport that just copies
+  to and from RAM so the call itself is all that gets measured
+*/
+
+#include "Adafruit_GenericDevice.h"
+
+#define ITERATIONS 10000
+
+class RAMTransport {
+public:
+  uint8_t regs[16];
+
+  bool read(uint8_t *buffer, size_t len) {
+    memcpy(buffer, regs, len);
+    return true;
+  }
+  bool write(const uint8_t *buffer, size_t len) {
+    memcpy(regs, buffer, len);
+    return true;
+  }
+  bool readRegister(uint8_t *addr_buf, uint8_t addrsiz, uint8_t *data,
+                    uint16_t datalen) {
+    (void)addrsiz;
+    memcpy(data, &regs[addr_buf[0] & 0x0F], datalen);
+    return true;
+  }
+  bool writeRegister(uint8_t *addr_buf, uint8_t addrsiz, const uint8_t *data,
+                     uint16_t datalen) {
+    (void)addrsiz;
+    memcpy(&regs[addr_buf[0] & 0x0F], data, datalen);
+    return true;
+  }
+
+  static bool readreg_func(void *thiz, uint8_t *addr_buf, uint8_t addrsiz,
+                           uint8_t *data, uint16_t datalen) {
+    return ((RAMTransport *)thiz)->readRegister(addr_buf, addrsiz, data,
+                                                datalen);
+  }
+  static bool read_func(void *thiz, uint8_t *buffer, size_t len) {
+    return ((RAMTransport *)thiz)->read(buffer, len);
+  }
+  static bool write_func(void *thiz, const uint8_t *buffer, size_t len) {
+    return ((RAMTransport *)thiz)->write(buffer, len);
+  }
+};
+
+RAMTransport ram;
+Adafruit_GenericDevice pointer_dev(&ram, RAMTransport::read_func,
+                                   RAMTransport::write_func,
+                                   RAMTransport::readreg_func);
+Adafruit_GenericDeviceT<RAMTransport> template_dev(&ram);
+
+volatile uint8_t sink;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+  delay(100);
+  Serial.println("Generic Device call overhead benchmark");
+
+  pointer_dev.begin();
+  template_dev.begin();
+
+  uint8_t addr = 0x03, data;
+
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    pointer_dev.readRegister(&addr, 1, &data, 1);
+    sink = data;
+  }
+  uint32_t pointer_us = micros() - start;
+
+  start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    template_dev.readRegister(&addr, 1, &data, 1);
+    sink = data;
+  }
+  uint32_t template_us = micros() - start;
+
+  Serial.print("Function pointers: ");
+  Serial.print(pointer_us);
+  Serial.print(" us for ");
+  Serial.print(ITERATIONS);
+  Serial.println(" register reads");
+  Serial.print("Templated:         ");
+  Serial.print(template_us);
+  Serial.print(" us for ");
+  Serial.print(ITERATIONS);
+  Serial.println(" register reads");
+}
+
+void loop() { delay(1000); }
@@ -38,13 +38,15 @@ private:
 
   static bool uart_read(void *thiz, uint8_t *buffer, size_t len) {
     TMC2209_UART *dev = (TMC2209_UART *)thiz;
-    uint16_t timeout = 100;
-    while (dev->_uart_stream->available() < len && timeout--) {
-      delay(1);
-    }
-    if (timeout == 0) {
-      DEBUG_PRINTLN("Read timeout!");
-      return false;
+    // spin on a microsecond deadline rather than delay(1), which would add
+    // at least a millisecond to every register read
+    uint32_t start = micros();
+    while (dev->_uart_stream->available() < (int)len) {
+      if ((micros() - start) > 100000) {
+        DEBUG_PRINTLN("Read timeout!");
+        return false;
+      }
+      yield();
     }
 
     DEBUG_PRINT("Reading: ");
@@ -157,20 +159,9 @@ private:
     return true;
   }
 
+  // Trinamic's UART CRC, table driven rather than bit by bit
   static uint8_t calcCRC(uint8_t *data, uint8_t length) {
-    uint8_t crc = 0;
-    for (uint8_t i = 0; i < length; i++) {
-      uint8_t currentByte = data[i];
-      for (uint8_t j = 0; j < 8; j++) {
-        if ((crc >> 7) ^ (currentByte & 0x01)) {
-          crc = (crc << 1) ^ 0x07;
-        } else {
-          crc = crc << 1;
-        }
-        currentByte = currentByte >> 1;
-      }
-    }
-    return crc;
+    return Adafruit_BusIO_CRC::compute(&busio_crc8_tmc, data, length);
   }
 
 public:
@@ -28,25 +28,27 @@ public:
   }
 
   // Static callback for reading data from UART
-  // Includes timeout and will return false if not enough data available
+  // GenericDevice only asks for bytes that uart_available() said are there
   static bool uart_read(void *thiz, uint8_t *buffer, size_t len) {
     UARTDevice *dev = (UARTDevice *)thiz;
-    uint16_t timeout = 100;
-    while (dev->_serial->available() < len && timeout--) {
-      delay(1);
-    }
-    if (timeout == 0) {
-      return false;
-    }
     for (size_t i = 0; i < len; i++) {
       buffer[i] = dev->_serial->read();
     }
     return true;
   }
 
+  // Static callback telling GenericDevice how many bytes can be read
+  static int uart_available(void *thiz) {
+    UARTDevice *dev = (UARTDevice *)thiz;
+    return dev->_serial->available();
+  }
+
   // Create a GenericDevice instance using our callbacks
   Adafruit_GenericDevice *createDevice() {
-    return new Adafruit_GenericDevice(this, uart_read, uart_write);
+    Adafruit_GenericDevice *device =
+        new Adafruit_GenericDevice(this, uart_read, uart_write);
+    device->setAvailableFunction(uart_available);
+    return device;
   }
 
 private:
@@ -79,8 +81,9 @@ void setup() {
     return;
   }
 
+  // Returns as soon as the 8th byte is in, or after 100ms
   Serial.println("Reading response...");
-  if (!device->read(read_buf, 8)) {
+  if (!device->readTimeout(read_buf, 8, 100000)) {
     Serial.println("Read failed!");
     return;
   }
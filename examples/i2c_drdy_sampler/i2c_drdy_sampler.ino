@@ -0,0 +1,50 @@
+// Reads the accelerometer/gyro block of an MPU-6050 style sensor every time
+// its INT pin says there is new data, without the main loop having to poll
+
+#include <Adafruit_BusIO_Sampler.h>
+#include <Adafruit_I2CDevice.h>
+
+#define I2C_ADDRESS 0x68
+#define DATA_REG 0x3B // 14 bytes of accel, temperature and gyro
+#define DRDY_PIN 2
+
+Adafruit_I2CDevice i2c_dev = Adafruit_I2CDevice(I2C_ADDRESS);
+Adafruit_BusIO_Sampler sampler = Adafruit_BusIO_Sampler(&i2c_dev, DATA_REG);
+uint8_t ping[14], pong[14];
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("I2C DRDY sampler test");
+
+  if (!i2c_dev.begin()) {
+    Serial.print("Did not find device at 0x");
+    Serial.println(i2c_dev.address(), HEX);
+    while (1)
+      ;
+  }
+
+  uint8_t wake[2] = {0x6B, 0x00}; // out of sleep
+  i2c_dev.write(wake, 2);
+  uint8_t int_enable[2] = {0x38, 0x01}; // data ready interrupt
+  i2c_dev.write(int_enable, 2);
+
+  sampler.begin(ping, pong, sizeof(ping), DRDY_PIN, RISING);
+}
+
+void loop() {
+  sampler.service(); // does the actual read, if the INT pin fired
+
+  uint32_t timestamp;
+  const uint8_t *sample = sampler.take(&timestamp);
+  if (sample) {
+    int16_t ax = (sample[0] << 8) | sample[1];
+    Serial.print(timestamp);
+    Serial.print(": ax = ");
+    Serial.print(ax);
+    Serial.print(", lost = ");
+    Serial.println(sampler.overruns());
+  }
+}
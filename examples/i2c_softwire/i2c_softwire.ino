@@ -0,0 +1,40 @@
+#include <Adafruit_I2CDevice.h>
+#include <Adafruit_SoftI2C.h>
+
+// Any two pins will do, as long as they have pullups
+#define SOFT_SDA 5
+#define SOFT_SCL 6
+
+#define I2C_ADDRESS 0x60
+Adafruit_SoftI2C softwire = Adafruit_SoftI2C(SOFT_SDA, SOFT_SCL, 400000);
+Adafruit_I2CDevice i2c_dev = Adafruit_I2CDevice(I2C_ADDRESS, &softwire);
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("Software I2C device test");
+
+  if (!i2c_dev.begin()) {
+    Serial.print("Did not find device at 0x");
+    Serial.println(i2c_dev.address(), HEX);
+    while (1)
+      ;
+  }
+  Serial.print("Device found on address 0x");
+  Serial.println(i2c_dev.address(), HEX);
+
+  // read a register by writing first, then reading after a repeated start
+  uint8_t buffer[2] = {0x0C, 0};
+  i2c_dev.write_then_read(buffer, 1, buffer, 2, false);
+  Serial.print("Write then Read: ");
+  for (uint8_t i = 0; i < 2; i++) {
+    Serial.print("0x");
+    Serial.print(buffer[i], HEX);
+    Serial.print(", ");
+  }
+  Serial.println();
+}
+
+void loop() {}
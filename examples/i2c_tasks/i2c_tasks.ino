@@ -0,0 +1,56 @@
+// Two I2C devices, each driven by its own task. While one waits out its
+// conversion time, the scheduler runs the other one instead of blocking
+
+#include <Adafruit_BusIO_Register.h>
+#include <Adafruit_BusIO_Task.h>
+#include <Adafruit_I2CDevice.h>
+
+Adafruit_I2CDevice dev_a = Adafruit_I2CDevice(0x40);
+Adafruit_I2CDevice dev_b = Adafruit_I2CDevice(0x41);
+Adafruit_BusIO_Scheduler scheduler;
+
+// Anything a task needs to keep across a wait lives in its state struct
+typedef struct {
+  const char *name;
+  Adafruit_BusIO_Register *command;
+  Adafruit_BusIO_Register *result;
+  uint32_t conversion_us;
+} sensor_task_t;
+
+busio_task_state_t sensorTask(busio_pt_t *pt, void *arg) {
+  sensor_task_t *s = (sensor_task_t *)arg;
+
+  BUSIO_PT_BEGIN(pt);
+  while (1) {
+    s->command->write(0x01); // start a conversion
+    BUSIO_PT_SLEEP_US(pt, s->conversion_us);
+
+    Serial.print(s->name);
+    Serial.print(": 0x");
+    Serial.println(s->result->read(), HEX);
+    BUSIO_PT_YIELD(pt);
+  }
+  BUSIO_PT_END(pt);
+}
+
+Adafruit_BusIO_Register cmd_a = Adafruit_BusIO_Register(&dev_a, 0x00);
+Adafruit_BusIO_Register res_a = Adafruit_BusIO_Register(&dev_a, 0x01, 2);
+Adafruit_BusIO_Register cmd_b = Adafruit_BusIO_Register(&dev_b, 0x00);
+Adafruit_BusIO_Register res_b = Adafruit_BusIO_Register(&dev_b, 0x01, 2);
+sensor_task_t task_a = {"A", &cmd_a, &res_a, 20000};
+sensor_task_t task_b = {"B", &cmd_b, &res_b, 5000};
+
+void setup() {
+  while (!Serial) {
+    delay(10);
+  }
+  Serial.begin(115200);
+  Serial.println("I2C task scheduler test");
+
+  dev_a.begin();
+  dev_b.begin();
+  scheduler.add(sensorTask, &task_a);
+  scheduler.add(sensorTask, &task_b);
+}
+
+void loop() { scheduler.run(); }
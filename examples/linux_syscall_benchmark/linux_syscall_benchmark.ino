@@ -0,0 +1,113 @@
+/*
+  Count the system calls the Linux i2c-dev and spidev buses make for common
+  transactions. The buses run on mock system calls, so no devices (or even a
+  Linux board with them enabled) are needed, only the counts are of interest
+*/
+
+#include "Adafruit_BusIO_Linux.h"
+#include "Adafruit_BusIO_Register.h"
+
+#ifdef BUSIO_HAS_LINUX
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+
+#define ITERATIONS 1000
+
+uint32_t ioctls = 0;
+
+int mock_open(const char *path, int flags) {
+  (void)path;
+  (void)flags;
+  return 3;
+}
+int mock_close(int fd) {
+  (void)fd;
+  return 0;
+}
+int mock_ioctl(int fd, unsigned long request, void *arg) {
+  (void)fd;
+  ioctls++;
+  if (request == I2C_RDWR) {
+    return ((struct i2c_rdwr_ioctl_data *)arg)->nmsgs;
+  }
+  return 0;
+}
+
+const busio_linux_ops_t mock = {mock_open, mock_close, mock_ioctl};
+
+Adafruit_LinuxI2C i2c_bus("/dev/i2c-1", &mock);
+Adafruit_I2CDevice i2c_dev(0x48, &i2c_bus);
+Adafruit_BusIO_Register i2c_reg(&i2c_dev, 0x00, 2, MSBFIRST);
+
+Adafruit_LinuxSPI spi_bus("/dev/spidev0.0", &mock);
+Adafruit_SPIDevice spi_dev(&spi_bus, 1000000);
+Adafruit_BusIO_Register spi_reg(&spi_dev, 0x0F, ADDRBIT8_HIGH_TOREAD, 2);
+
+void report(const char *what, uint32_t start) {
+  Serial.print(what);
+  Serial.print((float)(ioctls - start) / ITERATIONS);
+  Serial.println(" ioctls each");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+  delay(100);
+  Serial.println("Linux bus system call benchmark");
+
+  i2c_dev.begin(false);
+  spi_dev.begin();
+
+  uint8_t addr = 0x00, data[2];
+
+  uint32_t start = ioctls;
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    i2c_dev.write(&addr, 1);
+    i2c_dev.read(data, 2);
+  }
+  report("I2C write, then read:      ", start);
+
+  start = ioctls;
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    i2c_reg.read();
+  }
+  report("I2C register read:         ", start);
+
+  start = ioctls;
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    spi_reg.read();
+  }
+  report("SPI register read:         ", start);
+
+  uint8_t cmd[1] = {0x2C}, reply[4], next[1] = {0x29};
+  busio_spi_segment_t segments[3] = {{cmd, nullptr, 1, true},
+                                     {nullptr, reply, 4, true},
+                                     {next, nullptr, 1, false}};
+  start = ioctls;
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    spi_dev.transferBatch(segments, 3);
+  }
+  report("SPI batch of 3 segments:   ", start);
+
+  uint8_t black[2] = {0x00, 0x00};
+  start = ioctls;
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    spi_dev.writeRepeated(black, 2, 240, cmd, 1);
+  }
+  report("SPI 480 byte pattern fill: ", start);
+}
+
+#else
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+  Serial.println("This example needs a Linux board");
+}
+
+#endif
+
+void loop() { delay(1000); }
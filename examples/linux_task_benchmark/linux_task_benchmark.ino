@@ -0,0 +1,131 @@
+/*
+  Time the same sensor readings done two ways on a Linux i2c-dev bus: one
+  device after the other, blocking through each conversion, and as tasks on
+  an Adafruit_BusIO_Scheduler, where one device's conversion overlaps the
+  other's. The bus runs on mock system calls that take as long as the
+  transfer would at 100KHz, so no devices are needed
+*/
+
+#include "Adafruit_BusIO_Linux.h"
+#include "Adafruit_BusIO_Register.h"
+#include "Adafruit_BusIO_Task.h"
+
+#ifdef BUSIO_HAS_LINUX
+
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+
+#define READINGS 20
+
+uint32_t ioctls = 0;
+
+int mock_open(const char *path, int flags) {
+  (void)path;
+  (void)flags;
+  return 3;
+}
+int mock_close(int fd) {
+  (void)fd;
+  return 0;
+}
+int mock_ioctl(int fd, unsigned long request, void *arg) {
+  (void)fd;
+  ioctls++;
+  if (request != I2C_RDWR) {
+    return 0;
+  }
+  struct i2c_rdwr_ioctl_data *rdwr = (struct i2c_rdwr_ioctl_data *)arg;
+  uint32_t bits = 0;
+  for (uint32_t i = 0; i < rdwr->nmsgs; i++) {
+    bits += (rdwr->msgs[i].len + 1) * 9; // address and data, with ACKs
+  }
+  delayMicroseconds(bits * 10);
+  return rdwr->nmsgs;
+}
+
+const busio_linux_ops_t mock = {mock_open, mock_close, mock_ioctl};
+
+Adafruit_LinuxI2C i2c_bus("/dev/i2c-1", &mock);
+Adafruit_I2CDevice dev_a(0x40, &i2c_bus);
+Adafruit_I2CDevice dev_b(0x41, &i2c_bus);
+Adafruit_BusIO_Register cmd_a(&dev_a, 0x00);
+Adafruit_BusIO_Register res_a(&dev_a, 0x01, 2);
+Adafruit_BusIO_Register cmd_b(&dev_b, 0x00);
+Adafruit_BusIO_Register res_b(&dev_b, 0x01, 2);
+
+// Anything a task needs to keep across a wait lives in its state struct
+typedef struct {
+  Adafruit_BusIO_Register *command;
+  Adafruit_BusIO_Register *result;
+  uint32_t conversion_us;
+  uint8_t count;
+} sensor_t;
+
+sensor_t sensor_a = {&cmd_a, &res_a, 20000, 0};
+sensor_t sensor_b = {&cmd_b, &res_b, 5000, 0};
+
+void readBlocking(sensor_t *s) {
+  s->command->write(0x01); // start a conversion
+  delayMicroseconds(s->conversion_us);
+  s->result->read();
+}
+
+busio_task_state_t sensorTask(busio_pt_t *pt, void *arg) {
+  sensor_t *s = (sensor_t *)arg;
+
+  BUSIO_PT_BEGIN(pt);
+  for (s->count = 0; s->count < READINGS; s->count++) {
+    s->command->write(0x01); // start a conversion
+    BUSIO_PT_SLEEP_US(pt, s->conversion_us);
+    s->result->read();
+  }
+  BUSIO_PT_END(pt);
+}
+
+void report(const char *what, uint32_t start_us, uint32_t start_ioctls) {
+  Serial.print(what);
+  Serial.print((micros() - start_us) / 1000.0);
+  Serial.print(" ms, ");
+  Serial.print(ioctls - start_ioctls);
+  Serial.println(" ioctls");
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+  delay(100);
+  Serial.println("Linux bus task scheduler benchmark");
+
+  dev_a.begin(false);
+  dev_b.begin(false);
+
+  uint32_t start_ioctls = ioctls;
+  uint32_t start = micros();
+  for (uint8_t i = 0; i < READINGS; i++) {
+    readBlocking(&sensor_a);
+    readBlocking(&sensor_b);
+  }
+  report("Blocking, one after the other: ", start, start_ioctls);
+
+  Adafruit_BusIO_Scheduler scheduler;
+  scheduler.add(sensorTask, &sensor_a);
+  scheduler.add(sensorTask, &sensor_b);
+  start_ioctls = ioctls;
+  start = micros();
+  scheduler.runAll();
+  report("Tasks, interleaved:            ", start, start_ioctls);
+}
+
+#else
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial)
+    ;
+  Serial.println("This example needs a Linux board");
+}
+
+#endif
+
+void loop() { delay(1000); }